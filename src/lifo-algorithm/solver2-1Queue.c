@@ -5,7 +5,8 @@
 #include "function.h"
 #include <stdbool.h>
 
-#define MAXQUEUE 10000
+#define CHUNKSIZE 1024
+#define MAXBACKOFF 1024 // longest idle spin, in pause instructions
 
 struct Interval {
     double left;    // left boundary
@@ -16,93 +17,277 @@ struct Interval {
     double f_right; // function value at right boundary
 };
 
+// fixed-size block of queue storage; chunks are linked into a stack
+struct Chunk {
+    struct Interval entry[CHUNKSIZE]; // array of chunk entries
+    struct Chunk *prev;               // chunk below this one in the stack
+};
+
 struct Queue {
-    struct Interval entry[MAXQUEUE]; // array of queue entries
-    int top;                         // index of last entry
+    struct Chunk *chunk;             // chunk holding the last entry
+    struct Chunk *spare;             // emptied chunks kept for reuse
+    int top;                         // index of last entry within chunk
+    int count;                       // total number of queue entries
     omp_lock_t lock;                 // lock for synchronization
 };
 
-int total = 0;
-int total_processed = 0;
+// number of intervals that are queued or currently being processed
+int outstanding = 0;
 
 // add an interval to the queue
 void enqueue(struct Interval interval, struct Queue *queue_p) {
     omp_set_lock(&(queue_p->lock));
-    if (queue_p->top == MAXQUEUE - 1) {
-        printf("Maximum queue size exceeded - exiting\n");
-        exit(1);
+    if (queue_p->chunk == NULL || queue_p->top == CHUNKSIZE - 1) {
+        // Current chunk is full, reuse a spare one or allocate a new one.
+        // A new chunk is first touched by the thread that needs it, so it
+        // is placed in that thread's local memory.
+        struct Chunk *chunk = queue_p->spare;
+        if (chunk != NULL) {
+            queue_p->spare = chunk->prev;
+        } else {
+            chunk = malloc(sizeof(struct Chunk));
+            if (chunk == NULL) {
+                printf("Unable to allocate queue storage - exiting\n");
+                exit(1);
+            }
+        }
+        chunk->prev = queue_p->chunk;
+        queue_p->chunk = chunk;
+        queue_p->top = -1;
     }
     queue_p->top++;
-    queue_p->entry[queue_p->top].left = interval.left;
-    queue_p->entry[queue_p->top].right = interval.right;
-    queue_p->entry[queue_p->top].tol = interval.tol;
-    queue_p->entry[queue_p->top].f_left = interval.f_left;
-    queue_p->entry[queue_p->top].f_mid = interval.f_mid;
-    queue_p->entry[queue_p->top].f_right = interval.f_right;
+    queue_p->count++;
+    queue_p->chunk->entry[queue_p->top].left = interval.left;
+    queue_p->chunk->entry[queue_p->top].right = interval.right;
+    queue_p->chunk->entry[queue_p->top].tol = interval.tol;
+    queue_p->chunk->entry[queue_p->top].f_left = interval.f_left;
+    queue_p->chunk->entry[queue_p->top].f_mid = interval.f_mid;
+    queue_p->chunk->entry[queue_p->top].f_right = interval.f_right;
     omp_unset_lock(&(queue_p->lock));
 }
 
 // extract last interval from queue
 struct Interval dequeue(struct Queue *queue_p) {
     omp_set_lock(&(queue_p->lock));
-    if (queue_p->top == -1) {
+    if (queue_p->count == 0) {
         omp_unset_lock(&(queue_p->lock));
         printf("Attempt to extract from empty queue - exiting\n");
         exit(1);
     }
 
     struct Interval interval;
-    interval.left = queue_p->entry[queue_p->top].left;
-    interval.right = queue_p->entry[queue_p->top].right;
-    interval.tol = queue_p->entry[queue_p->top].tol;
-    interval.f_left = queue_p->entry[queue_p->top].f_left;
-    interval.f_mid = queue_p->entry[queue_p->top].f_mid;
-    interval.f_right = queue_p->entry[queue_p->top].f_right;
+    interval.left = queue_p->chunk->entry[queue_p->top].left;
+    interval.right = queue_p->chunk->entry[queue_p->top].right;
+    interval.tol = queue_p->chunk->entry[queue_p->top].tol;
+    interval.f_left = queue_p->chunk->entry[queue_p->top].f_left;
+    interval.f_mid = queue_p->chunk->entry[queue_p->top].f_mid;
+    interval.f_right = queue_p->chunk->entry[queue_p->top].f_right;
     queue_p->top--;
+    queue_p->count--;
+    if (queue_p->top == -1 && queue_p->chunk->prev != NULL) {
+        // Chunk is now empty, move it to the spare list and drop back a chunk
+        struct Chunk *chunk = queue_p->chunk;
+        queue_p->chunk = chunk->prev;
+        queue_p->top = CHUNKSIZE - 1;
+        chunk->prev = queue_p->spare;
+        queue_p->spare = chunk;
+    }
     omp_unset_lock(&(queue_p->lock));
     return interval;
 }
 
 // initialise queue
 void init(struct Queue *queue_p) {
+    queue_p->chunk = NULL;
+    queue_p->spare = NULL;
     queue_p->top = -1;
+    queue_p->count = 0;
     omp_init_lock(&(queue_p->lock));
 }
 
+// release queue storage
+void destroy(struct Queue *queue_p) {
+    struct Chunk *lists[2] = {queue_p->chunk, queue_p->spare};
+    for (int i = 0; i < 2; i++) {
+        while (lists[i] != NULL) {
+            struct Chunk *prev = lists[i]->prev;
+            free(lists[i]);
+            lists[i] = prev;
+        }
+    }
+    queue_p->chunk = NULL;
+    queue_p->spare = NULL;
+    queue_p->top = -1;
+    queue_p->count = 0;
+    omp_destroy_lock(&(queue_p->lock));
+}
+
 // return whether queue is empty
 int isempty(struct Queue *queue_p) {
     int empty;
     omp_set_lock(&(queue_p->lock));
-    empty = (queue_p->top == -1);
+    empty = (queue_p->count == 0);
     omp_unset_lock(&(queue_p->lock));
     return empty;
 }
 
+// spin for a while before polling the queue again, doubling the delay each
+// time, so that idle threads stay off the lock the workers need
+void backoff(int *delay) {
+    for (int k = 0; k < *delay; k++) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#else
+        __asm__ __volatile__("" ::: "memory");
+#endif
+    }
+    if (*delay < MAXBACKOFF) {
+        *delay *= 2;
+    }
+}
+
 // get current number of queue entries
 int size(struct Queue *queue_p) {
-    return (queue_p->top + 1);
+    return queue_p->count;
+}
+
+// converged interval recorded for position-ordered summation
+struct Leaf {
+    double left;    // left boundary
+    double quad;    // integral estimate over the interval
+};
+
+// per-thread partial sum, aligned so that each thread owns its cache line
+struct Accumulator {
+    _Alignas(64) double sum; // running sum of converged intervals
+    double comp;             // running compensation term (SUM_NEUMAIER)
+    struct Leaf *leaf;       // converged intervals (SUM_SORTED)
+    long count;              // number of recorded leaves
+    long capacity;           // allocated number of leaves
+};
+
+// add value to a compensated (Neumaier) running sum
+void neumaier(double *sum, double *comp, double value) {
+    double t = *sum + value;
+    if (fabs(*sum) >= fabs(value)) {
+        *comp += (*sum - t) + value;
+    } else {
+        *comp += (value - t) + *sum;
+    }
+    *sum = t;
+}
+
+// add the integral over a converged interval to a thread's accumulator
+void accumulate(struct Accumulator *acc, double left, double quad) {
+#if defined(SUM_SORTED)
+    if (acc->count == acc->capacity) {
+        acc->capacity = (acc->capacity == 0) ? CHUNKSIZE : 2 * acc->capacity;
+        acc->leaf = realloc(acc->leaf, acc->capacity * sizeof(struct Leaf));
+        if (acc->leaf == NULL) {
+            printf("Unable to allocate leaf storage - exiting\n");
+            exit(1);
+        }
+    }
+    acc->leaf[acc->count].left = left;
+    acc->leaf[acc->count].quad = quad;
+    acc->count++;
+#elif defined(SUM_NEUMAIER)
+    (void) left;
+    neumaier(&(acc->sum), &(acc->comp), quad);
+#else
+    (void) left;
+    acc->sum += quad;
+#endif
+}
+
+// order leaves by position
+int compare_leaf(const void *a, const void *b) {
+    double la = ((const struct Leaf *) a)->left;
+    double lb = ((const struct Leaf *) b)->left;
+    return (la > lb) - (la < lb);
+}
+
+// combine the per-thread accumulators in a fixed order and release them
+// With SUM_SORTED the leaves are summed in order of position, which gives
+// the same bits for any number of threads.
+double reduce(struct Accumulator *acc, int num_threads) {
+    double sum = 0.0, comp = 0.0;
+#if defined(SUM_SORTED)
+    long count = 0;
+    for (int i = 0; i < num_threads; i++) {
+        count += acc[i].count;
+    }
+    struct Leaf *leaf = malloc((count > 0 ? count : 1) * sizeof(struct Leaf));
+    if (leaf == NULL) {
+        printf("Unable to allocate leaf storage - exiting\n");
+        exit(1);
+    }
+    count = 0;
+    for (int i = 0; i < num_threads; i++) {
+        for (long j = 0; j < acc[i].count; j++) {
+            leaf[count++] = acc[i].leaf[j];
+        }
+        free(acc[i].leaf);
+    }
+    qsort(leaf, count, sizeof(struct Leaf), compare_leaf);
+    for (long j = 0; j < count; j++) {
+        neumaier(&sum, &comp, leaf[j].quad);
+    }
+    free(leaf);
+#else
+    for (int i = 0; i < num_threads; i++) {
+        neumaier(&sum, &comp, acc[i].sum);
+        neumaier(&sum, &comp, acc[i].comp);
+    }
+#endif
+    free(acc);
+    return sum + comp;
 }
 
 double simpson(double (*func)(double), struct Queue *queue) {
-    double quad = 0.0;
     int num_threads = omp_get_max_threads();
+    struct Accumulator *acc = aligned_alloc(64, num_threads * sizeof(struct Accumulator));
+    if (acc == NULL) {
+        printf("Unable to allocate accumulators - exiting\n");
+        exit(1);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        acc[i].sum = 0.0;
+        acc[i].comp = 0.0;
+        acc[i].leaf = NULL;
+        acc[i].count = 0;
+        acc[i].capacity = 0;
+    }
 
     // Keep working until the queue is empty
     #pragma omp parallel for schedule(static)
     for (int i = 0; i < num_threads; i++) {
+        struct Accumulator *own = &acc[omp_get_thread_num()];
+        int delay = 1;
         while (1) {
             struct Interval interval;
-            int empty;
+            int empty, done;
             #pragma omp critical
             {
                 empty = isempty(queue);
                 if (!empty) {
                     interval = dequeue(queue);
                 }
+                // An empty queue only means we are finished once no other thread
+                // is still working on an interval that may be split further
+                int remaining;
+                #pragma omp atomic read
+                remaining = outstanding;
+                done = empty && (remaining == 0);
             }
-            if (empty) {
+            if (done) {
                 break;
             }
+            if (empty) {
+                backoff(&delay);
+                continue;
+            }
+            delay = 1;
             double h = interval.right - interval.left;
             double c = (interval.left + interval.right) / 2.0;
             double d = (interval.left + c) / 2.0;
@@ -115,17 +300,10 @@ double simpson(double (*func)(double), struct Queue *queue) {
             double q2 = h / 12.0 * (interval.f_left + 4.0 * fd + 2.0 * interval.f_mid + 4.0 * fe + interval.f_right);
 
             if ((fabs(q2 - q1) < interval.tol) || ((interval.right - interval.left) < 1.0e-12)) {
-                // Tolerance is met, add to total
-                #pragma omp critical
-                {
-                    quad += q2 + (q2 - q1) / 15.0;
-                    total_processed++;
-                    if (total_processed == total) {
-                        // Convergence reached and all items processed
-                        printf("Convergence reached. Terminating the program.\n");
-                        exit(0);
-                    }
-                }
+                // Tolerance is met, add to this thread's total
+                accumulate(own, interval.left, q2 + (q2 - q1) / 15.0);
+                #pragma omp atomic
+                outstanding--;
             } else {
                 // Tolerance is not met, split interval in two and add both halves to the queue
                 struct Interval i1, i2;
@@ -148,13 +326,15 @@ double simpson(double (*func)(double), struct Queue *queue) {
                 {
                     enqueue(i1, queue);
                     enqueue(i2, queue);
-                    total += 2;
+                    // one interval consumed, two added
+                    #pragma omp atomic
+                    outstanding++;
                 }
             }
         }
     }
 
-    return quad;
+    return reduce(acc, num_threads);
 }
 
 int main(void) {
@@ -172,12 +352,13 @@ int main(void) {
     whole.f_mid = func1((whole.left + whole.right) / 2.0);
 
     enqueue(whole, &queue);
-    total = 1;
+    outstanding = 1;
     // Call queue-based quadrature routine
     double quad = simpson(func1, &queue);
     double time = omp_get_wtime() - start;
     printf("Result = %e\n", quad);
     printf("Time(s) = %f\n", time);
 
+    destroy(&queue);
     return 0;
 }
\ No newline at end of file
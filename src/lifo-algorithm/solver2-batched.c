@@ -0,0 +1,280 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include <stdatomic.h>
+#include "function.h"
+
+#define INITSIZE 1024
+#define BATCHSIZE 8 // maximum number of intervals evaluated together
+
+// Pending intervals are stored structure-of-arrays. The tolerance is the
+// same for every interval, so it is passed to simpson() once rather than
+// stored per entry, which brings each entry down from 48 to 40 bytes.
+
+// a batch of intervals taken off a deque, laid out for simd loops
+struct Batch {
+    double left[BATCHSIZE];    // left boundaries
+    double right[BATCHSIZE];   // right boundaries
+    double f_left[BATCHSIZE];  // function values at left boundaries
+    double f_mid[BATCHSIZE];   // function values at midpoints
+    double f_right[BATCHSIZE]; // function values at right boundaries
+};
+
+// circular arrays backing a deque; replaced by ones twice the size when full
+struct Array {
+    long size;                       // number of entries (power of two)
+    double *left;                    // left boundaries
+    double *right;                   // right boundaries
+    double *f_left;                  // function values at left boundaries
+    double *f_mid;                   // function values at midpoints
+    double *f_right;                 // function values at right boundaries
+    struct Array *retired;           // smaller array this one replaced
+};
+
+// Chase-Lev work-stealing deque, one per thread.
+// The owner pushes and pops at the bottom without locking; other threads
+// steal the oldest (and therefore widest) intervals from the top.
+struct Deque {
+    struct Array *_Atomic array;     // current storage
+    _Atomic long top;                // index of oldest entry (steal end)
+    char pad[64];                    // keep top and bottom on separate cache lines
+    _Atomic long bottom;             // index one past newest entry (owner end)
+};
+
+// number of intervals that are queued or currently being processed
+_Atomic long outstanding = 0;
+
+// allocate circular arrays with the given number of entries
+struct Array *newarray(long size, struct Array *retired) {
+    struct Array *array = malloc(sizeof(struct Array));
+    if (array != NULL) {
+        array->left = malloc(5 * size * sizeof(double));
+    }
+    if (array == NULL || array->left == NULL) {
+        printf("Unable to allocate queue storage - exiting\n");
+        exit(1);
+    }
+    array->right = array->left + size;
+    array->f_left = array->right + size;
+    array->f_mid = array->f_left + size;
+    array->f_right = array->f_mid + size;
+    array->size = size;
+    array->retired = retired;
+    return array;
+}
+
+// initialise deque
+void init(struct Deque *deque_p) {
+    atomic_init(&(deque_p->array), newarray(INITSIZE, NULL));
+    atomic_init(&(deque_p->top), 0);
+    atomic_init(&(deque_p->bottom), 0);
+}
+
+// release deque storage, including arrays retired by grow()
+void destroy(struct Deque *deque_p) {
+    struct Array *array = atomic_load(&(deque_p->array));
+    while (array != NULL) {
+        struct Array *retired = array->retired;
+        free(array->left);
+        free(array);
+        array = retired;
+    }
+    atomic_store(&(deque_p->array), NULL);
+}
+
+// copy entry i of array into position j of batch
+void get(struct Array *array, long i, struct Batch *batch, int j) {
+    i = i % array->size;
+    batch->left[j] = array->left[i];
+    batch->right[j] = array->right[i];
+    batch->f_left[j] = array->f_left[i];
+    batch->f_mid[j] = array->f_mid[i];
+    batch->f_right[j] = array->f_right[i];
+}
+
+// replace full arrays with ones twice the size (owner only)
+// The old arrays are kept alive because a thief may still be reading from them;
+// the new ones are first touched by the owner, so they land in local memory.
+struct Array *grow(struct Deque *deque_p, struct Array *array, long top, long bottom) {
+    struct Array *bigger = newarray(2 * array->size, array);
+    for (long i = top; i < bottom; i++) {
+        long from = i % array->size, to = i % bigger->size;
+        bigger->left[to] = array->left[from];
+        bigger->right[to] = array->right[from];
+        bigger->f_left[to] = array->f_left[from];
+        bigger->f_mid[to] = array->f_mid[from];
+        bigger->f_right[to] = array->f_right[from];
+    }
+    atomic_store_explicit(&(deque_p->array), bigger, memory_order_release);
+    return bigger;
+}
+
+// add an interval at the owner end of the deque (owner only)
+void push(double left, double right, double f_left, double f_mid, double f_right, struct Deque *deque_p) {
+    long b = atomic_load_explicit(&(deque_p->bottom), memory_order_relaxed);
+    long t = atomic_load_explicit(&(deque_p->top), memory_order_acquire);
+    struct Array *array = atomic_load_explicit(&(deque_p->array), memory_order_relaxed);
+    if (b - t >= array->size) {
+        array = grow(deque_p, array, t, b);
+    }
+    long i = b % array->size;
+    array->left[i] = left;
+    array->right[i] = right;
+    array->f_left[i] = f_left;
+    array->f_mid[i] = f_mid;
+    array->f_right[i] = f_right;
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&(deque_p->bottom), b + 1, memory_order_relaxed);
+}
+
+// take the newest interval from the owner end of the deque into batch entry j (owner only)
+// returns 0 if the deque is empty
+int pop(struct Deque *deque_p, struct Batch *batch, int j) {
+    long b = atomic_load_explicit(&(deque_p->bottom), memory_order_relaxed) - 1;
+    atomic_store_explicit(&(deque_p->bottom), b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&(deque_p->top), memory_order_relaxed);
+
+    if (t > b) {
+        // deque was already empty
+        atomic_store_explicit(&(deque_p->bottom), b + 1, memory_order_relaxed);
+        return 0;
+    }
+
+    get(atomic_load_explicit(&(deque_p->array), memory_order_relaxed), b, batch, j);
+    if (t == b) {
+        // last entry - race against thieves for it
+        int won = atomic_compare_exchange_strong_explicit(&(deque_p->top), &t, t + 1,
+                                                          memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&(deque_p->bottom), b + 1, memory_order_relaxed);
+        return won;
+    }
+    return 1;
+}
+
+// take the oldest interval from the steal end of another thread's deque into batch entry j
+// returns 0 if the deque is empty or another thread got there first
+int steal(struct Deque *deque_p, struct Batch *batch, int j) {
+    long t = atomic_load_explicit(&(deque_p->top), memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&(deque_p->bottom), memory_order_acquire);
+
+    if (t >= b) {
+        return 0;
+    }
+
+    get(atomic_load_explicit(&(deque_p->array), memory_order_acquire), t, batch, j);
+    return atomic_compare_exchange_strong_explicit(&(deque_p->top), &t, t + 1,
+                                                   memory_order_seq_cst, memory_order_relaxed);
+}
+
+double simpson(void (*func)(const double *, double *, int), struct Deque *deques, int num_threads, double tol) {
+    double quad = 0.0;
+
+    // Each thread works from its own deque and steals when it runs dry
+    #pragma omp parallel num_threads(num_threads) reduction(+:quad)
+    {
+        int id = omp_get_thread_num();
+        struct Deque *own = &deques[id];
+        int victim = id;
+
+        while (1) {
+            struct Batch batch;
+            double x[2 * BATCHSIZE], fx[2 * BATCHSIZE];
+            double q1[BATCHSIZE], q2[BATCHSIZE];
+            int n = 0;
+
+            // Take up to BATCHSIZE of the newest intervals from our own deque
+            while (n < BATCHSIZE && pop(own, &batch, n)) {
+                n++;
+            }
+
+            // Own deque is empty, try the other threads in turn
+            for (int k = 1; n == 0 && k < num_threads; k++) {
+                victim = (victim + 1) % num_threads;
+                if (victim != id) {
+                    n = steal(&deques[victim], &batch, 0);
+                }
+            }
+
+            if (n == 0) {
+                // No work anywhere we looked - finished only if nothing is outstanding
+                if (atomic_load(&outstanding) == 0) {
+                    break;
+                }
+                continue;
+            }
+
+            // Evaluate the one-quarter points, then the three-quarter points, of every interval in one call
+            #pragma omp simd
+            for (int j = 0; j < n; j++) {
+                double c = (batch.left[j] + batch.right[j]) / 2.0;
+                x[j] = (batch.left[j] + c) / 2.0;
+                x[n + j] = (c + batch.right[j]) / 2.0;
+            }
+            func(x, fx, 2 * n);
+
+            // Calculate integral estimates using 3 and 5 points respectively
+            #pragma omp simd
+            for (int j = 0; j < n; j++) {
+                double h = batch.right[j] - batch.left[j];
+                q1[j] = h / 6.0 * (batch.f_left[j] + 4.0 * batch.f_mid[j] + batch.f_right[j]);
+                q2[j] = h / 12.0 * (batch.f_left[j] + 4.0 * fx[j] + 2.0 * batch.f_mid[j] + 4.0 * fx[n + j] + batch.f_right[j]);
+            }
+
+            // Push children in reverse so the leftmost interval is popped first
+            for (int j = n - 1; j >= 0; j--) {
+                if ((fabs(q2[j] - q1[j]) < tol) || ((batch.right[j] - batch.left[j]) < 1.0e-12)) {
+                    // Tolerance is met, add to this thread's total
+                    quad += q2[j] + (q2[j] - q1[j]) / 15.0;
+                    atomic_fetch_sub(&outstanding, 1);
+                } else {
+                    // Tolerance is not met, split interval in two and push both halves on our own deque
+                    double c = (batch.left[j] + batch.right[j]) / 2.0;
+
+                    // one interval consumed, two added
+                    atomic_fetch_add(&outstanding, 1);
+                    push(c, batch.right[j], batch.f_mid[j], fx[n + j], batch.f_right[j], own);
+                    push(batch.left[j], c, batch.f_left[j], fx[j], batch.f_mid[j], own);
+                }
+            }
+        }
+    }
+
+    return quad;
+}
+
+int main(void) {
+    int num_threads = omp_get_max_threads();
+    struct Deque *deques = malloc(num_threads * sizeof(struct Deque));
+    double x[3], fx[3];
+    // Initialise one deque per thread
+    for (int i = 0; i < num_threads; i++) {
+        init(&deques[i]);
+    }
+    double start = omp_get_wtime();
+    // Add initial interval to the first thread's deque
+    double left = 0.0;
+    double right = 10.0;
+    double tol = 1e-06;
+    x[0] = left;
+    x[1] = (left + right) / 2.0;
+    x[2] = right;
+    func1_vec(x, fx, 3);
+
+    push(left, right, fx[0], fx[1], fx[2], &deques[0]);
+    outstanding = 1;
+    // Call batched work-stealing quadrature routine
+    double quad = simpson(func1_vec, deques, num_threads, tol);
+    double time = omp_get_wtime() - start;
+    printf("Batch Size = %d\n", BATCHSIZE);
+    printf("Result = %e\n", quad);
+    printf("Time(s) = %f\n", time);
+
+    for (int i = 0; i < num_threads; i++) {
+        destroy(&deques[i]);
+    }
+    free(deques);
+    return 0;
+}
@@ -0,0 +1,245 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include <stdatomic.h>
+#include "function.h"
+
+#define INITSIZE 1024
+
+struct Interval {
+    double left;    // left boundary
+    double right;   // right boundary
+    double tol;     // tolerance
+    double f_left;  // function value at left boundary
+    double f_mid;   // function value at midpoint
+    double f_right; // function value at right boundary
+};
+
+// circular array backing a deque; replaced by one twice the size when full
+struct Array {
+    long size;                       // number of entries (power of two)
+    struct Interval *entry;          // circular array of deque entries
+    struct Array *retired;           // smaller array this one replaced
+};
+
+// Chase-Lev work-stealing deque, one per thread.
+// The owner pushes and pops at the bottom without locking; other threads
+// steal the oldest (and therefore widest) intervals from the top.
+struct Deque {
+    struct Array *_Atomic array;     // current storage
+    _Atomic long top;                // index of oldest entry (steal end)
+    char pad[64];                    // keep top and bottom on separate cache lines
+    _Atomic long bottom;             // index one past newest entry (owner end)
+};
+
+// number of intervals that are queued or currently being processed
+_Atomic long outstanding = 0;
+
+// allocate a circular array with the given number of entries
+struct Array *newarray(long size, struct Array *retired) {
+    struct Array *array = malloc(sizeof(struct Array));
+    if (array != NULL) {
+        array->entry = malloc(size * sizeof(struct Interval));
+    }
+    if (array == NULL || array->entry == NULL) {
+        printf("Unable to allocate queue storage - exiting\n");
+        exit(1);
+    }
+    array->size = size;
+    array->retired = retired;
+    return array;
+}
+
+// initialise deque
+void init(struct Deque *deque_p) {
+    atomic_init(&(deque_p->array), newarray(INITSIZE, NULL));
+    atomic_init(&(deque_p->top), 0);
+    atomic_init(&(deque_p->bottom), 0);
+}
+
+// release deque storage, including arrays retired by grow()
+void destroy(struct Deque *deque_p) {
+    struct Array *array = atomic_load(&(deque_p->array));
+    while (array != NULL) {
+        struct Array *retired = array->retired;
+        free(array->entry);
+        free(array);
+        array = retired;
+    }
+    atomic_store(&(deque_p->array), NULL);
+}
+
+// replace a full array with one twice the size (owner only)
+// The old array is kept alive because a thief may still be reading from it;
+// the new one is first touched by the owner, so it lands in local memory.
+struct Array *grow(struct Deque *deque_p, struct Array *array, long top, long bottom) {
+    struct Array *bigger = newarray(2 * array->size, array);
+    for (long i = top; i < bottom; i++) {
+        bigger->entry[i % bigger->size] = array->entry[i % array->size];
+    }
+    atomic_store_explicit(&(deque_p->array), bigger, memory_order_release);
+    return bigger;
+}
+
+// add an interval at the owner end of the deque (owner only)
+void push(struct Interval interval, struct Deque *deque_p) {
+    long b = atomic_load_explicit(&(deque_p->bottom), memory_order_relaxed);
+    long t = atomic_load_explicit(&(deque_p->top), memory_order_acquire);
+    struct Array *array = atomic_load_explicit(&(deque_p->array), memory_order_relaxed);
+    if (b - t >= array->size) {
+        array = grow(deque_p, array, t, b);
+    }
+    array->entry[b % array->size] = interval;
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&(deque_p->bottom), b + 1, memory_order_relaxed);
+}
+
+// take the newest interval from the owner end of the deque (owner only)
+// returns 0 if the deque is empty
+int pop(struct Deque *deque_p, struct Interval *interval) {
+    long b = atomic_load_explicit(&(deque_p->bottom), memory_order_relaxed) - 1;
+    atomic_store_explicit(&(deque_p->bottom), b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&(deque_p->top), memory_order_relaxed);
+
+    if (t > b) {
+        // deque was already empty
+        atomic_store_explicit(&(deque_p->bottom), b + 1, memory_order_relaxed);
+        return 0;
+    }
+
+    struct Array *array = atomic_load_explicit(&(deque_p->array), memory_order_relaxed);
+    *interval = array->entry[b % array->size];
+    if (t == b) {
+        // last entry - race against thieves for it
+        int won = atomic_compare_exchange_strong_explicit(&(deque_p->top), &t, t + 1,
+                                                          memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&(deque_p->bottom), b + 1, memory_order_relaxed);
+        return won;
+    }
+    return 1;
+}
+
+// take the oldest interval from the steal end of another thread's deque
+// returns 0 if the deque is empty or another thread got there first
+int steal(struct Deque *deque_p, struct Interval *interval) {
+    long t = atomic_load_explicit(&(deque_p->top), memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&(deque_p->bottom), memory_order_acquire);
+
+    if (t >= b) {
+        return 0;
+    }
+
+    struct Array *array = atomic_load_explicit(&(deque_p->array), memory_order_acquire);
+    *interval = array->entry[t % array->size];
+    return atomic_compare_exchange_strong_explicit(&(deque_p->top), &t, t + 1,
+                                                   memory_order_seq_cst, memory_order_relaxed);
+}
+
+double simpson(double (*func)(double), struct Deque *deques, int num_threads) {
+    double quad = 0.0;
+
+    // Each thread works from its own deque and steals when it runs dry
+    #pragma omp parallel num_threads(num_threads) reduction(+:quad)
+    {
+        int id = omp_get_thread_num();
+        struct Deque *own = &deques[id];
+        int victim = id;
+
+        while (1) {
+            struct Interval interval;
+            int found = pop(own, &interval);
+
+            // Own deque is empty, try the other threads in turn
+            for (int k = 1; !found && k < num_threads; k++) {
+                victim = (victim + 1) % num_threads;
+                if (victim != id) {
+                    found = steal(&deques[victim], &interval);
+                }
+            }
+
+            if (!found) {
+                // No work anywhere we looked - finished only if nothing is outstanding
+                if (atomic_load(&outstanding) == 0) {
+                    break;
+                }
+                continue;
+            }
+
+            double h = interval.right - interval.left;
+            double c = (interval.left + interval.right) / 2.0;
+            double d = (interval.left + c) / 2.0;
+            double e = (c + interval.right) / 2.0;
+            double fd = func(d);
+            double fe = func(e);
+
+            // Calculate integral estimates using 3 and 5 points respectively
+            double q1 = h / 6.0 * (interval.f_left + 4.0 * interval.f_mid + interval.f_right);
+            double q2 = h / 12.0 * (interval.f_left + 4.0 * fd + 2.0 * interval.f_mid + 4.0 * fe + interval.f_right);
+
+            if ((fabs(q2 - q1) < interval.tol) || ((interval.right - interval.left) < 1.0e-12)) {
+                // Tolerance is met, add to this thread's total
+                quad += q2 + (q2 - q1) / 15.0;
+                atomic_fetch_sub(&outstanding, 1);
+            } else {
+                // Tolerance is not met, split interval in two and push both halves on our own deque
+                struct Interval i1, i2;
+
+                i1.left = interval.left;
+                i1.right = c;
+                i1.tol = interval.tol;
+                i1.f_left = interval.f_left;
+                i1.f_mid = fd;
+                i1.f_right = interval.f_mid;
+
+                i2.left = c;
+                i2.right = interval.right;
+                i2.tol = interval.tol;
+                i2.f_left = interval.f_mid;
+                i2.f_mid = fe;
+                i2.f_right = interval.f_right;
+
+                // one interval consumed, two added
+                atomic_fetch_add(&outstanding, 1);
+                push(i2, own);
+                push(i1, own);
+            }
+        }
+    }
+
+    return quad;
+}
+
+int main(void) {
+    int num_threads = omp_get_max_threads();
+    struct Deque *deques = malloc(num_threads * sizeof(struct Deque));
+    struct Interval whole;
+    // Initialise one deque per thread
+    for (int i = 0; i < num_threads; i++) {
+        init(&deques[i]);
+    }
+    double start = omp_get_wtime();
+    // Add initial interval to the first thread's deque
+    whole.left = 0.0;
+    whole.right = 10.0;
+    whole.tol = 1e-06;
+    whole.f_left = func1(whole.left);
+    whole.f_right = func1(whole.right);
+    whole.f_mid = func1((whole.left + whole.right) / 2.0);
+
+    push(whole, &deques[0]);
+    outstanding = 1;
+    // Call work-stealing quadrature routine
+    double quad = simpson(func1, deques, num_threads);
+    double time = omp_get_wtime() - start;
+    printf("Result = %e\n", quad);
+    printf("Time(s) = %f\n", time);
+
+    for (int i = 0; i < num_threads; i++) {
+        destroy(&deques[i]);
+    }
+    free(deques);
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "accumulator.h"
+
+#define LEAFCHUNK 1024 // initial number of recorded leaves per thread
+
+// add value to a compensated (Neumaier) running sum
+static void neumaier(double *sum, double *comp, double value) {
+    double t = *sum + value;
+    if (fabs(*sum) >= fabs(value)) {
+        *comp += (*sum - t) + value;
+    } else {
+        *comp += (value - t) + *sum;
+    }
+    *sum = t;
+}
+
+#if defined(SUM_SORTED)
+// Order leaves by position, then by value. Positions can tie (the boxes of
+// a cubature sharing a lower edge, or the problems of integrate_many()), and
+// qsort() leaves the order of ties open; leaves equal in both are
+// interchangeable, so the sum no longer depends on it.
+static int compare_leaf(const void *a, const void *b) {
+    const struct Leaf *la = a, *lb = b;
+    if (la->left != lb->left) {
+        return (la->left > lb->left) - (la->left < lb->left);
+    }
+    return (la->quad > lb->quad) - (la->quad < lb->quad);
+}
+#endif
+
+struct Accumulator *new_accumulators(int num_threads) {
+    struct Accumulator *acc = aligned_alloc(64, num_threads * sizeof(struct Accumulator));
+    if (acc == NULL) {
+        printf("Unable to allocate accumulators - exiting\n");
+        exit(1);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        acc[i].sum = 0.0;
+        acc[i].comp = 0.0;
+        acc[i].leaf = NULL;
+        acc[i].count = 0;
+        acc[i].capacity = 0;
+    }
+    return acc;
+}
+
+void accumulate(struct Accumulator *acc, double left, double quad) {
+#if defined(SUM_SORTED)
+    if (acc->count == acc->capacity) {
+        acc->capacity = (acc->capacity == 0) ? LEAFCHUNK : 2 * acc->capacity;
+        acc->leaf = realloc(acc->leaf, acc->capacity * sizeof(struct Leaf));
+        if (acc->leaf == NULL) {
+            printf("Unable to allocate leaf storage - exiting\n");
+            exit(1);
+        }
+    }
+    acc->leaf[acc->count].left = left;
+    acc->leaf[acc->count].quad = quad;
+    acc->count++;
+#elif defined(SUM_NEUMAIER)
+    (void) left;
+    neumaier(&(acc->sum), &(acc->comp), quad);
+#else
+    (void) left;
+    acc->sum += quad;
+#endif
+}
+
+double partial_sum(const struct Accumulator *acc, int num_threads) {
+    double sum = 0.0, comp = 0.0;
+    for (int i = 0; i < num_threads; i++) {
+#if defined(SUM_SORTED)
+        for (long j = 0; j < acc[i].count; j++) {
+            neumaier(&sum, &comp, acc[i].leaf[j].quad);
+        }
+#else
+        neumaier(&sum, &comp, acc[i].sum);
+        neumaier(&sum, &comp, acc[i].comp);
+#endif
+    }
+    return sum + comp;
+}
+
+double reduce(struct Accumulator *acc, int num_threads) {
+    double sum = 0.0, comp = 0.0;
+#if defined(SUM_SORTED)
+    long count = 0;
+    for (int i = 0; i < num_threads; i++) {
+        count += acc[i].count;
+    }
+    struct Leaf *leaf = malloc((count > 0 ? count : 1) * sizeof(struct Leaf));
+    if (leaf == NULL) {
+        printf("Unable to allocate leaf storage - exiting\n");
+        exit(1);
+    }
+    count = 0;
+    for (int i = 0; i < num_threads; i++) {
+        for (long j = 0; j < acc[i].count; j++) {
+            leaf[count++] = acc[i].leaf[j];
+        }
+        free(acc[i].leaf);
+    }
+    qsort(leaf, count, sizeof(struct Leaf), compare_leaf);
+    for (long j = 0; j < count; j++) {
+        neumaier(&sum, &comp, leaf[j].quad);
+    }
+    free(leaf);
+#else
+    for (int i = 0; i < num_threads; i++) {
+        neumaier(&sum, &comp, acc[i].sum);
+        neumaier(&sum, &comp, acc[i].comp);
+    }
+#endif
+    free(acc);
+    return sum + comp;
+}
@@ -0,0 +1,38 @@
+#ifndef ACCUMULATOR_H
+#define ACCUMULATOR_H
+
+// Per-thread partial sums of converged intervals.
+// By default each thread keeps a plain running sum. Compile with
+// -DSUM_NEUMAIER for compensated summation, or with -DSUM_SORTED to record
+// every converged interval and sum them in order of position, which gives
+// bitwise identical results for any number of threads.
+
+// converged interval recorded for position-ordered summation
+struct Leaf {
+    double left;    // left boundary
+    double quad;    // integral estimate over the interval
+};
+
+// per-thread partial sum, aligned so that each thread owns its cache line
+struct Accumulator {
+    _Alignas(64) double sum; // running sum of converged intervals
+    double comp;             // running compensation term (SUM_NEUMAIER)
+    struct Leaf *leaf;       // converged intervals (SUM_SORTED)
+    long count;              // number of recorded leaves
+    long capacity;           // allocated number of leaves
+};
+
+// allocate and clear one accumulator per thread
+struct Accumulator *new_accumulators(int num_threads);
+
+// add the integral over a converged interval to a thread's accumulator
+void accumulate(struct Accumulator *acc, double left, double quad);
+
+// sum of the accumulators so far, leaving them in place
+// Not order-fixed under SUM_SORTED; used for checkpoints only.
+double partial_sum(const struct Accumulator *acc, int num_threads);
+
+// combine the accumulators in a fixed order and release them
+double reduce(struct Accumulator *acc, int num_threads);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#define MAXBACKOFF 1024 // longest idle spin, in pause instructions
+
+// Spin for a while before looking for work again, doubling the delay each
+// time, so that idle threads stay off the locks and cache lines the workers
+// need. Start *delay at 1 and reset it to 1 whenever work is found.
+static inline void backoff(int *delay) {
+    for (int k = 0; k < *delay; k++) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#else
+        __asm__ __volatile__("" ::: "memory");
+#endif
+    }
+    if (*delay < MAXBACKOFF) {
+        *delay *= 2;
+    }
+}
+
+#endif
@@ -0,0 +1,327 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include <stdatomic.h>
+#include "accumulator.h"
+#include "backoff.h"
+#include "probe.h"
+#include "rule.h"
+#include "solvers.h"
+
+#define INITSIZE 1024
+
+// Pending intervals are stored structure-of-arrays. The tolerance is the
+// same for every interval, so it is held once per integration rather than
+// stored per entry; each entry is the five doubles of the interval and its
+// share of the pending error (progress), 48 bytes.
+
+// a batch of intervals taken off a deque, laid out for simd loops
+struct Batch {
+    double left[MAXBATCH];    // left boundaries
+    double right[MAXBATCH];   // right boundaries
+    double f_left[MAXBATCH];  // function values at left boundaries
+    double f_mid[MAXBATCH];   // function values at midpoints
+    double f_right[MAXBATCH]; // function values at right boundaries
+    double share[MAXBATCH];   // half the parent's error estimate (progress)
+};
+
+// circular arrays backing a deque; replaced by ones twice the size when full
+struct Frontier {
+    long size;                       // number of entries (power of two)
+    double *left;                    // left boundaries
+    double *right;                   // right boundaries
+    double *f_left;                  // function values at left boundaries
+    double *f_mid;                   // function values at midpoints
+    double *f_right;                 // function values at right boundaries
+    double *share;                   // half the parent's error estimate (progress)
+    struct Frontier *retired;        // smaller array this one replaced
+};
+
+// Chase-Lev work-stealing deque of Frontier storage, one per thread.
+// The owner pushes and pops at the bottom without locking; other threads
+// steal the oldest (and therefore widest) intervals from the top.
+struct BatchDeque {
+    struct Frontier *_Atomic array;  // current storage
+    _Atomic long top;                // index of oldest entry (steal end)
+    char pad[64];                    // keep top and bottom on separate cache lines
+    _Atomic long bottom;             // index one past newest entry (owner end)
+};
+
+// allocate circular arrays with the given number of entries
+static struct Frontier *newarray(long size, struct Frontier *retired) {
+    struct Frontier *array = malloc(sizeof(struct Frontier));
+    if (array != NULL) {
+        array->left = malloc(6 * size * sizeof(double));
+    }
+    if (array == NULL || array->left == NULL) {
+        printf("Unable to allocate queue storage - exiting\n");
+        exit(1);
+    }
+    array->right = array->left + size;
+    array->f_left = array->right + size;
+    array->f_mid = array->f_left + size;
+    array->f_right = array->f_mid + size;
+    array->share = array->f_right + size;
+    array->size = size;
+    array->retired = retired;
+    return array;
+}
+
+// initialise deque
+static void init(struct BatchDeque *deque_p) {
+    atomic_init(&(deque_p->array), newarray(INITSIZE, NULL));
+    atomic_init(&(deque_p->top), 0);
+    atomic_init(&(deque_p->bottom), 0);
+}
+
+// release deque storage, including arrays retired by grow()
+static void destroy(struct BatchDeque *deque_p) {
+    struct Frontier *array = atomic_load(&(deque_p->array));
+    while (array != NULL) {
+        struct Frontier *retired = array->retired;
+        free(array->left);
+        free(array);
+        array = retired;
+    }
+    atomic_store(&(deque_p->array), NULL);
+}
+
+// copy entry i of array into position j of batch
+static void get(struct Frontier *array, long i, struct Batch *batch, int j) {
+    i = i % array->size;
+    batch->left[j] = array->left[i];
+    batch->right[j] = array->right[i];
+    batch->f_left[j] = array->f_left[i];
+    batch->f_mid[j] = array->f_mid[i];
+    batch->f_right[j] = array->f_right[i];
+    batch->share[j] = array->share[i];
+}
+
+// replace full arrays with ones twice the size (owner only)
+// The old arrays are kept alive because a thief may still be reading from them;
+// the new ones are first touched by the owner, so they land in local memory.
+static struct Frontier *grow(struct BatchDeque *deque_p, struct Frontier *array, long top, long bottom) {
+    struct Frontier *bigger = newarray(2 * array->size, array);
+    for (long i = top; i < bottom; i++) {
+        long from = i % array->size, to = i % bigger->size;
+        bigger->left[to] = array->left[from];
+        bigger->right[to] = array->right[from];
+        bigger->f_left[to] = array->f_left[from];
+        bigger->f_mid[to] = array->f_mid[from];
+        bigger->f_right[to] = array->f_right[from];
+        bigger->share[to] = array->share[from];
+    }
+    atomic_store_explicit(&(deque_p->array), bigger, memory_order_release);
+    return bigger;
+}
+
+// add an interval at the owner end of the deque (owner only)
+static void push(double left, double right, double f_left, double f_mid, double f_right, double share,
+                 struct BatchDeque *deque_p) {
+    long b = atomic_load_explicit(&(deque_p->bottom), memory_order_relaxed);
+    long t = atomic_load_explicit(&(deque_p->top), memory_order_acquire);
+    struct Frontier *array = atomic_load_explicit(&(deque_p->array), memory_order_relaxed);
+    if (b - t >= array->size) {
+        array = grow(deque_p, array, t, b);
+    }
+    long i = b % array->size;
+    array->left[i] = left;
+    array->right[i] = right;
+    array->f_left[i] = f_left;
+    array->f_mid[i] = f_mid;
+    array->f_right[i] = f_right;
+    array->share[i] = share;
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&(deque_p->bottom), b + 1, memory_order_relaxed);
+}
+
+// take the newest interval from the owner end of the deque into batch entry j (owner only)
+// returns 0 if the deque is empty
+static int pop(struct BatchDeque *deque_p, struct Batch *batch, int j) {
+    long b = atomic_load_explicit(&(deque_p->bottom), memory_order_relaxed) - 1;
+    atomic_store_explicit(&(deque_p->bottom), b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&(deque_p->top), memory_order_relaxed);
+
+    if (t > b) {
+        // deque was already empty
+        atomic_store_explicit(&(deque_p->bottom), b + 1, memory_order_relaxed);
+        return 0;
+    }
+
+    get(atomic_load_explicit(&(deque_p->array), memory_order_relaxed), b, batch, j);
+    if (t == b) {
+        // last entry - race against thieves for it
+        int won = atomic_compare_exchange_strong_explicit(&(deque_p->top), &t, t + 1,
+                                                          memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&(deque_p->bottom), b + 1, memory_order_relaxed);
+        return won;
+    }
+    return 1;
+}
+
+// take the oldest interval from the steal end of another thread's deque into batch entry j
+// returns 0 if the deque is empty or another thread got there first
+static int steal(struct BatchDeque *deque_p, struct Batch *batch, int j) {
+    long t = atomic_load_explicit(&(deque_p->top), memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&(deque_p->bottom), memory_order_acquire);
+
+    if (t >= b) {
+        return 0;
+    }
+
+    get(atomic_load_explicit(&(deque_p->array), memory_order_acquire), t, batch, j);
+    return atomic_compare_exchange_strong_explicit(&(deque_p->top), &t, t + 1,
+                                                   memory_order_seq_cst, memory_order_relaxed);
+}
+
+double integrate_batched(double (*func)(double), struct Interval whole, const struct Options *opts, int num_threads) {
+    struct BatchDeque *deques = malloc(num_threads * sizeof(struct BatchDeque));
+    struct Accumulator *acc = new_accumulators(num_threads);
+    void (*batch_func)(const double *, double *, int) = opts->batch_func;
+    const struct GKRule *gk = gk_rule(opts->rule);
+    int batch_size = opts->batch_size;
+    double tol = whole.tol;
+    _Atomic long outstanding = 1; // intervals that are queued or currently being processed
+
+    if (deques == NULL) {
+        printf("Unable to allocate deques - exiting\n");
+        exit(1);
+    }
+    if (batch_size < 1) {
+        batch_size = 1;
+    } else if (batch_size > MAXBATCH) {
+        batch_size = MAXBATCH;
+    }
+
+    // Each thread works from its own deque and steals when it runs dry
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int id = omp_get_thread_num();
+        int team = omp_get_num_threads(); // may be fewer than requested
+        struct BatchDeque *own = &deques[id];
+        struct Accumulator *sum = &acc[id];
+        struct ThreadStats *st = thread_stats(opts->stats, id);
+
+        cache_enter(opts->cache);
+        int victim = id;
+        int delay = 1; // idle spin, see backoff()
+
+        // Each thread initialises its own deque so its storage is local to it
+        init(own);
+        if (id == 0) {
+            push(whole.left, whole.right, whole.f_left, whole.f_mid, whole.f_right, whole.share, own);
+        }
+        #pragma omp barrier
+
+        while (1) {
+            struct Batch batch;
+            double x[2 * MAXBATCH], fx[2 * MAXBATCH];
+            double quad[MAXBATCH], err[MAXBATCH];
+            int n = 0;
+            double t = probe_start(st);
+
+            // Take up to batch_size of the newest intervals from our own deque
+            while (n < batch_size && pop(own, &batch, n)) {
+                n++;
+            }
+
+            // Own deque is empty, try the other threads in turn
+            for (int k = 1; n == 0 && k < team; k++) {
+                victim = (victim + 1) % team;
+                if (victim != id) {
+                    n = steal(&deques[victim], &batch, 0);
+                }
+            }
+
+            if (n == 0) {
+                // No work anywhere we looked - finished only if nothing is outstanding,
+                // otherwise wait a while before looking again
+                if (atomic_load(&outstanding) == 0) {
+                    probe_idle(st, t);
+                    break;
+                }
+                backoff(&delay);
+                probe_idle(st, t);
+                continue;
+            }
+            delay = 1;
+
+            t = probe_start(st);
+            if (gk == NULL) {
+                // Evaluate the one-quarter points, then the three-quarter points, of every interval in one call
+                #pragma omp simd
+                for (int j = 0; j < n; j++) {
+                    double c = (batch.left[j] + batch.right[j]) / 2.0;
+                    x[j] = (batch.left[j] + c) / 2.0;
+                    x[n + j] = (c + batch.right[j]) / 2.0;
+                }
+                if (batch_func != NULL) {
+                    batch_func(x, fx, 2 * n);
+                } else {
+                    for (int j = 0; j < 2 * n; j++) {
+                        fx[j] = func(x[j]);
+                    }
+                }
+                probe_eval(st, 2 * n, t);
+
+                // Calculate integral estimates using 3 and 5 points respectively
+                #pragma omp simd
+                for (int j = 0; j < n; j++) {
+                    double h = batch.right[j] - batch.left[j];
+                    double q1 = h / 6.0 * (batch.f_left[j] + 4.0 * batch.f_mid[j] + batch.f_right[j]);
+                    double q2 = h / 12.0 * (batch.f_left[j] + 4.0 * fx[j] + 2.0 * batch.f_mid[j] + 4.0 * fx[n + j] + batch.f_right[j]);
+                    err[j] = fabs(q2 - q1);
+                    quad[j] = q2 + (q2 - q1) / 15.0;
+                }
+            } else {
+                // Every node of every interval in one call; the subintervals reuse none of them
+                if (batch_func != NULL) {
+                    gk_apply_batch(gk, batch_func, batch.left, batch.right, n, quad, err);
+                } else {
+                    for (int j = 0; j < n; j++) {
+                        quad[j] = gk_apply(gk, func, batch.left[j], batch.right[j], &err[j]);
+                    }
+                }
+                for (int j = 0; j < 2 * n; j++) {
+                    fx[j] = 0.0;
+                }
+                probe_eval(st, (2 * gk->n + 1) * n, t);
+            }
+            probe_intervals(st, n);
+            budget_charge(opts->budget, (gk == NULL) ? 2 * n : (2 * gk->n + 1) * n);
+
+            // Push children in reverse so the leftmost interval is popped first
+            for (int j = n - 1; j >= 0; j--) {
+                double h = batch.right[j] - batch.left[j];
+                if ((err[j] < tol) || (h < 1.0e-12) || budget_stop(opts->budget, h, err[j])) {
+                    // Tolerance is met or the budget is spent, add to this thread's total
+                    accumulate(sum, batch.left[j], quad[j]);
+                    progress_leaf(opts->progress, id, h, quad[j], batch.share[j]);
+                    atomic_fetch_sub(&outstanding, 1);
+                } else {
+                    // Tolerance is not met, split interval in two and push both halves on our own deque
+                    double c = (batch.left[j] + batch.right[j]) / 2.0;
+                    progress_split(opts->progress, id, batch.share[j], err[j]);
+
+                    // one interval consumed, two added
+                    atomic_fetch_add(&outstanding, 1);
+                    push(c, batch.right[j], batch.f_mid[j], fx[n + j], batch.f_right[j], err[j] / 2.0, own);
+                    push(batch.left[j], c, batch.f_left[j], fx[j], batch.f_mid[j], err[j] / 2.0, own);
+                }
+            }
+            if (st != NULL) {
+                probe_depth(st, atomic_load(&(own->bottom)) - atomic_load(&(own->top)));
+            }
+        }
+
+        // Thieves may still be reading from our deque until everyone is done
+        #pragma omp barrier
+        destroy(own);
+    }
+
+    free(deques);
+    return reduce(acc, num_threads);
+}
@@ -0,0 +1,223 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <omp.h>
+#include "function.h"
+#include "quadrature.h"
+#include "stats.h"
+
+#define MAXLIST 32 // most entries in a -t or -e list
+
+// Benchmark every strategy over a matrix of integrands, tolerances and thread
+// counts. Each configuration is timed reps times and summarised by the median
+// and 95th percentile; one further run with stats on counts the integrand
+// evaluations. Parallel efficiency is relative to the same strategy on one
+// thread, so it is only filled in when 1 is among the thread counts.
+// Integrands defined here are also run through solvers from specialise.h,
+// which call them directly, as the "specialised" strategy.
+// Results are written as CSV, one row per configuration.
+
+// smooth integrand
+static double smooth(double x) {
+    return exp(x);
+}
+
+// integrable singularity at x = 1/3, which bisection never lands on
+static double singular(double x) {
+    return 1.0 / sqrt(fabs(x - 1.0 / 3.0));
+}
+
+// work-stealing solvers specialised for the integrands above, benchmarked as "specialised"
+#define SPECIALISE_NAME integrate_smooth
+#define SPECIALISE_FUNC smooth
+#include "specialise.h"
+
+#define SPECIALISE_NAME integrate_singular
+#define SPECIALISE_FUNC singular
+#include "specialise.h"
+
+// func1 is defined in function.c, so this one is only inlined under -flto
+#define SPECIALISE_NAME integrate_oscillatory
+#define SPECIALISE_FUNC func1
+#include "specialise.h"
+
+// integrand and domain with a known integral
+struct Case {
+    const char *name;                                  // class of integrand
+    double (*func)(double);                            // integrand
+    void (*batch_func)(const double *, double *, int); // vectorised integrand, or NULL
+    double (*specialised)(double, double, double, const struct Options *); // from specialise.h, or NULL
+    double a, b;                                       // domain
+    double reference;                                  // exact integral
+};
+
+// integrate one case, through its specialised solver if asked
+static double run(const struct Case *test, double tol, const struct Options *opts, int specialised) {
+    if (specialised) {
+        return test->specialised(test->a, test->b, tol, opts);
+    }
+    return integrate(test->func, test->a, test->b, tol, opts);
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+// parse a comma-separated list of numbers, returns the number of entries
+static int parse_list(const char *text, double *list) {
+    int n = 0;
+    char *end;
+    while (n < MAXLIST) {
+        list[n++] = strtod(text, &end);
+        if (end == text || (*end != ',' && *end != '\0')) {
+            printf("Cannot parse list %s - exiting\n", text);
+            exit(1);
+        }
+        if (*end == '\0') {
+            break;
+        }
+        text = end + 1;
+    }
+    return n;
+}
+
+// usage: bench [-r reps] [-t threads,...] [-e tol,...] [-s strategy|specialised] [-o file.csv]
+int main(int argc, char **argv) {
+    // func1 settles at alpha (1 - (1 - step)^numsteps), so its integral has a closed form
+    double settle = 1.0 - pow(1.0 - 0.0001, 1000);
+    struct Case cases[] = {
+        {"smooth", smooth, NULL, integrate_smooth, 0.0, 1.0, exp(1.0) - 1.0},
+        {"smooth", smooth, NULL, integrate_smooth, 0.0, 10.0, exp(10.0) - 1.0},
+        {"oscillatory", func1, func1_vec, integrate_oscillatory, 0.0, 0.02, settle * (1.0 - cos(100000.0 * 0.02))},
+        {"oscillatory", func1, func1_vec, integrate_oscillatory, 0.0, 0.2, settle * (1.0 - cos(100000.0 * 0.2))},
+        {"singular", singular, NULL, integrate_singular, 0.0, 1.0, 2.0 * sqrt(1.0 / 3.0) + 2.0 * sqrt(2.0 / 3.0)},
+    };
+    int num_cases = sizeof(cases) / sizeof(cases[0]);
+    double threads[MAXLIST] = {1, 2, 4}, tols[MAXLIST] = {1e-6, 1e-8};
+    int num_threads = 3, num_tols = 2, reps = 5, only = -1;
+    enum Strategy strategy;
+    FILE *out = stdout;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:t:e:s:o:")) != -1) {
+        switch (opt) {
+        case 'r':
+            reps = atoi(optarg);
+            if (reps < 1) {
+                reps = 1;
+            }
+            break;
+        case 't':
+            num_threads = parse_list(optarg, threads);
+            break;
+        case 'e':
+            num_tols = parse_list(optarg, tols);
+            break;
+        case 's':
+            if (strcmp(optarg, "specialised") == 0) {
+                only = NUM_STRATEGIES;
+                break;
+            }
+            if (!parse_strategy(optarg, &strategy)) {
+                printf("Unknown strategy %s - exiting\n", optarg);
+                exit(1);
+            }
+            only = (int) strategy;
+            break;
+        case 'o':
+            out = fopen(optarg, "w");
+            if (out == NULL) {
+                printf("Unable to open %s - exiting\n", optarg);
+                exit(1);
+            }
+            break;
+        default:
+            printf("usage: bench [-r reps] [-t threads,...] [-e tol,...] [-s strategy|specialised] [-o file.csv]\n");
+            exit(1);
+        }
+    }
+
+    // Ascending, so the one-thread baseline is measured first
+    qsort(threads, num_threads, sizeof(double), compare_double);
+
+    double *times = malloc(reps * sizeof(double));
+    struct Stats *stats = stats_create();
+    if (times == NULL) {
+        printf("Unable to allocate timings - exiting\n");
+        exit(1);
+    }
+
+    fprintf(out, "strategy,threads,integrand,a,b,tol,reps,median_s,p95_s,evaluations,evals_per_s,"
+                 "efficiency,result,reference,abs_error\n");
+    // One extra pass, s == NUM_STRATEGIES, runs the specialised solvers
+    for (int s = 0; s <= NUM_STRATEGIES; s++) {
+        int specialised = (s == NUM_STRATEGIES);
+        const char *name = specialised ? "specialised" : strategy_name((enum Strategy) s);
+        if (only >= 0 && s != only) {
+            continue;
+        }
+        for (int c = 0; c < num_cases; c++) {
+            if (specialised && cases[c].specialised == NULL) {
+                continue;
+            }
+            for (int e = 0; e < num_tols; e++) {
+                double single = 0.0; // median time on one thread
+                for (int t = 0; t < num_threads; t++) {
+                    struct Options opts;
+                    int p = (int) threads[t];
+                    if (s == STRATEGY_SERIAL && p != 1) {
+                        continue;
+                    }
+                    default_options(&opts);
+                    opts.strategy = specialised ? STRATEGY_WORK_STEALING : (enum Strategy) s;
+                    opts.num_threads = p;
+                    opts.batch_func = cases[c].batch_func;
+                    fprintf(stderr, "%s %s [%g, %g] tol %g threads %d\n", name,
+                            cases[c].name, cases[c].a, cases[c].b, tols[e], p);
+
+                    double result = 0.0;
+                    for (int r = 0; r < reps; r++) {
+                        double start = omp_get_wtime();
+                        result = run(&cases[c], tols[e], &opts, specialised);
+                        times[r] = omp_get_wtime() - start;
+                    }
+                    opts.stats = stats;
+                    run(&cases[c], tols[e], &opts, specialised);
+                    long evaluations = 0;
+                    for (int i = 0; i < stats->num_threads; i++) {
+                        evaluations += stats->thread[i].evaluations;
+                    }
+
+                    // Nearest-rank median and 95th percentile
+                    qsort(times, reps, sizeof(double), compare_double);
+                    double median = times[(reps - 1) / 2];
+                    double p95 = times[(int) ceil(0.95 * reps) - 1];
+                    if (p == 1) {
+                        single = median;
+                    }
+
+                    fprintf(out, "%s,%d,%s,%g,%g,%g,%d,%.9f,%.9f,%ld,%.6e,", name, p,
+                            cases[c].name, cases[c].a, cases[c].b, tols[e], reps, median, p95, evaluations,
+                            (median > 0.0) ? evaluations / median : 0.0);
+                    if (single > 0.0) {
+                        fprintf(out, "%.4f,", single / (p * median));
+                    } else {
+                        fprintf(out, ",");
+                    }
+                    fprintf(out, "%.15e,%.15e,%.3e\n", result, cases[c].reference, fabs(result - cases[c].reference));
+                    fflush(out);
+                }
+            }
+        }
+    }
+
+    stats_free(stats);
+    free(times);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
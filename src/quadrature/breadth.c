@@ -0,0 +1,232 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "accumulator.h"
+#include "level.h"
+#include "probe.h"
+#include "solvers.h"
+
+// Breadth-first refinement: the frontier holds every unconverged interval of
+// one level of the tree. Each level is processed by all threads together,
+// each taking a contiguous block, and a prefix sum over the number of splits
+// per thread gives every thread its place in the next level's frontier.
+// Scheduling costs a few barriers per level instead of a lock per interval,
+// and the children stay in left-to-right order.
+
+// per-level scratch space for the quarter points and the convergence test
+struct Work {
+    long capacity;          // allocated number of intervals
+    double *x_d, *x_e;      // one-quarter and three-quarter points
+    double *f_d, *f_e;      // function values at those points
+    char *split;            // whether each interval is split
+};
+
+void reserve_level(struct Level *level, long n) {
+    if (n <= level->capacity) {
+        return;
+    }
+    long capacity = (level->capacity == 0) ? 1024 : level->capacity;
+    while (capacity < n) {
+        capacity *= 2;
+    }
+    double **field[5] = {&(level->left), &(level->right), &(level->f_left), &(level->f_mid), &(level->f_right)};
+    for (int k = 0; k < 5; k++) {
+        *field[k] = realloc(*field[k], capacity * sizeof(double));
+        if (*field[k] == NULL) {
+            printf("Unable to allocate queue storage - exiting\n");
+            exit(1);
+        }
+    }
+    level->capacity = capacity;
+}
+
+void free_level(struct Level *level) {
+    free(level->left);
+    free(level->right);
+    free(level->f_left);
+    free(level->f_mid);
+    free(level->f_right);
+    level->left = level->right = level->f_left = level->f_mid = level->f_right = NULL;
+    level->count = 0;
+    level->capacity = 0;
+}
+
+// make room for at least n intervals in the scratch space
+static void reserve_work(struct Work *work, long n) {
+    if (n <= work->capacity) {
+        return;
+    }
+    long capacity = (work->capacity == 0) ? 1024 : work->capacity;
+    while (capacity < n) {
+        capacity *= 2;
+    }
+    double *block = realloc(work->x_d, 4 * capacity * sizeof(double));
+    char *split = realloc(work->split, capacity);
+    if (block == NULL || split == NULL) {
+        printf("Unable to allocate queue storage - exiting\n");
+        exit(1);
+    }
+    work->x_d = block;
+    work->x_e = block + capacity;
+    work->f_d = block + 2 * capacity;
+    work->f_e = block + 3 * capacity;
+    work->split = split;
+    work->capacity = capacity;
+}
+
+double refine_levels(double (*func)(double), struct Level *start, double base, double tol, const struct Options *opts,
+                     int num_threads, long (*exchange)(struct Level *, void *), void *arg) {
+    struct Level levels[2] = {*start, {0}};
+    struct Level *cur = &levels[0], *next = &levels[1];
+    struct Work work = {0};
+    struct Accumulator *acc = new_accumulators(num_threads);
+    long *offset = malloc((num_threads + 1) * sizeof(long));
+    void (*batch_func)(const double *, double *, int) = opts->batch_func;
+    long remaining = cur->count; // intervals left in every process's frontier
+    double saved = omp_get_wtime(); // time of the last checkpoint
+
+    if (offset == NULL) {
+        printf("Unable to allocate queue storage - exiting\n");
+        exit(1);
+    }
+    if (exchange != NULL) {
+        remaining = exchange(cur, arg);
+    }
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int id = omp_get_thread_num();
+        int team = omp_get_num_threads(); // may be fewer than requested
+        struct Accumulator *sum = &acc[id];
+        struct ThreadStats *st = thread_stats(opts->stats, id);
+
+        cache_enter(opts->cache);
+
+        while (1) {
+            #pragma omp single
+            reserve_work(&work, cur->count);
+
+            if (remaining == 0) {
+                break;
+            }
+            long n = cur->count;
+            long lo = n * id / team, hi = n * (id + 1) / team;
+
+            // Get function values at one-quarter and three-quarter points of this thread's block
+            #pragma omp simd
+            for (long i = lo; i < hi; i++) {
+                double c = (cur->left[i] + cur->right[i]) / 2.0;
+                work.x_d[i] = (cur->left[i] + c) / 2.0;
+                work.x_e[i] = (c + cur->right[i]) / 2.0;
+            }
+            double t = probe_start(st);
+            if (batch_func != NULL) {
+                batch_func(&work.x_d[lo], &work.f_d[lo], (int) (hi - lo));
+                batch_func(&work.x_e[lo], &work.f_e[lo], (int) (hi - lo));
+            } else {
+                for (long i = lo; i < hi; i++) {
+                    work.f_d[i] = func(work.x_d[i]);
+                    work.f_e[i] = func(work.x_e[i]);
+                }
+            }
+            probe_eval(st, 2 * (hi - lo), t);
+            probe_intervals(st, hi - lo);
+            probe_depth(st, n);
+
+            long splits = 0;
+            for (long i = lo; i < hi; i++) {
+                double h = cur->right[i] - cur->left[i];
+
+                // Calculate integral estimates using 3 and 5 points respectively
+                double q1 = h / 6.0 * (cur->f_left[i] + 4.0 * cur->f_mid[i] + cur->f_right[i]);
+                double q2 = h / 12.0 * (cur->f_left[i] + 4.0 * work.f_d[i] + 2.0 * cur->f_mid[i] + 4.0 * work.f_e[i] + cur->f_right[i]);
+
+                if ((fabs(q2 - q1) < tol) || ((cur->right[i] - cur->left[i]) < 1.0e-12)) {
+                    // Tolerance is met, add to this thread's total
+                    accumulate(sum, cur->left[i], q2 + (q2 - q1) / 15.0);
+                    work.split[i] = 0;
+                } else {
+                    work.split[i] = 1;
+                    splits++;
+                }
+            }
+            offset[id + 1] = splits;
+
+            // Prefix sum over the threads' split counts gives each thread its
+            // first slot in the next level
+            t = probe_start(st);
+            #pragma omp barrier
+            probe_idle(st, t);
+            #pragma omp single
+            {
+                offset[0] = 0;
+                for (int k = 0; k < team; k++) {
+                    offset[k + 1] += offset[k];
+                }
+                reserve_level(next, 2 * offset[team]);
+                next->count = 2 * offset[team];
+            }
+
+            // Tolerance is not met, split interval in two and write both halves to the next level
+            long j = 2 * offset[id];
+            for (long i = lo; i < hi; i++) {
+                if (work.split[i]) {
+                    double c = (cur->left[i] + cur->right[i]) / 2.0;
+
+                    next->left[j] = cur->left[i];
+                    next->right[j] = c;
+                    next->f_left[j] = cur->f_left[i];
+                    next->f_mid[j] = work.f_d[i];
+                    next->f_right[j] = cur->f_mid[i];
+
+                    next->left[j + 1] = c;
+                    next->right[j + 1] = cur->right[i];
+                    next->f_left[j + 1] = cur->f_mid[i];
+                    next->f_mid[j + 1] = work.f_e[i];
+                    next->f_right[j + 1] = cur->f_right[i];
+                    j += 2;
+                }
+            }
+
+            #pragma omp barrier
+            #pragma omp master
+            {
+                struct Level *swap = cur;
+                cur = next;
+                next = swap;
+                remaining = (exchange != NULL) ? exchange(cur, arg) : cur->count;
+
+                // Every thread is between levels, so the frontier and sums are consistent
+                if (opts->checkpoint != NULL && (remaining == 0 || omp_get_wtime() - saved >= opts->checkpoint_interval)) {
+                    write_checkpoint(opts->checkpoint, tol, base + partial_sum(acc, num_threads), cur);
+                    saved = omp_get_wtime();
+                }
+            }
+            #pragma omp barrier
+        }
+    }
+
+    free_level(&levels[0]);
+    free_level(&levels[1]);
+    start->count = 0;
+    start->capacity = 0;
+    start->left = start->right = start->f_left = start->f_mid = start->f_right = NULL;
+    free(work.x_d);
+    free(work.split);
+    free(offset);
+    return base + reduce(acc, num_threads);
+}
+
+double integrate_breadth_first(double (*func)(double), struct Interval whole, const struct Options *opts, int num_threads) {
+    struct Level start = {0};
+
+    reserve_level(&start, 1);
+    start.left[0] = whole.left;
+    start.right[0] = whole.right;
+    start.f_left[0] = whole.f_left;
+    start.f_mid[0] = whole.f_mid;
+    start.f_right[0] = whole.f_right;
+    start.count = 1;
+    return refine_levels(func, &start, 0.0, whole.tol, opts, num_threads, NULL, NULL);
+}
@@ -0,0 +1,294 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "cache.h"
+#include "solvers.h"
+
+#define MAXLEVEL 50                      // resolution of the grid positions; levels up to MAXLEVEL - 2 are cached
+#define UNSET 0xfff8000000000001ULL      // NaN pattern marking a slot whose value is still being written
+#define CACHECHUNK 128                   // points looked up per call of the batch integrand
+static const char magic[8] = "QCACHE2"; // file format tag
+
+// one hash table entry; key is the grid position plus one so zero means empty
+struct Slot {
+    _Atomic uint64_t key;   // position on the 2^MAXLEVEL grid, plus one
+    _Atomic uint64_t value; // bits of the function value, or UNSET
+};
+
+struct Cache {
+    char key[CACHEKEY];          // caller's name for the integrand, NUL padded
+    double a, b;                 // domain the positions refer to
+    long capacity;               // number of slots (power of two)
+    int shift;                   // 64 - log2(capacity), so hash() keeps the top bits
+    _Atomic long count;          // number of used slots
+    struct Slot *slot;           // open-addressing table
+    double (*func)(double);      // integrand of the current run
+    void (*batch_func)(const double *, double *, int); // batch integrand of the current run
+};
+
+static _Thread_local struct Cache *active = NULL; // cache of the run this thread is working on
+
+// allocate an empty table with at least n slots
+static void new_table(struct Cache *cache, long n) {
+    long capacity = 1024;
+    int shift = 54;
+    while (capacity < n) {
+        capacity *= 2;
+        shift--;
+    }
+    cache->shift = shift;
+    cache->slot = malloc(capacity * sizeof(struct Slot));
+    if (cache->slot == NULL) {
+        printf("Unable to allocate cache - exiting\n");
+        exit(1);
+    }
+    for (long i = 0; i < capacity; i++) {
+        atomic_init(&(cache->slot[i].key), 0);
+        atomic_init(&(cache->slot[i].value), UNSET);
+    }
+    cache->capacity = capacity;
+    atomic_init(&(cache->count), 0);
+}
+
+// grid position of x plus one, or 0 if x is not a cacheable dyadic point
+// The level is MAXLEVEL minus the trailing zero bits of the position and the
+// index is the position with those bits shifted out. Rounding in the
+// midpoints and in the scaling moves t by well under a quarter of a grid
+// step, and points at level MAXLEVEL - 2 or coarser are at least four steps
+// apart, so rounding t to the nearest position cannot mix two of them up.
+static uint64_t key_of(const struct Cache *cache, double x) {
+    double t = ldexp((x - cache->a) / (cache->b - cache->a), MAXLEVEL);
+    double k = nearbyint(t);
+    if (!(k >= 0.0 && k <= ldexp(1.0, MAXLEVEL)) || fabs(t - k) > 0.25) {
+        return 0;
+    }
+    uint64_t position = (uint64_t) k;
+    if ((position & 3) != 0) {
+        return 0;
+    }
+    return position + 1;
+}
+
+// Fibonacci hashing; positions share many trailing zero bits, so only the
+// top bits of the product are well mixed
+static long hash(const struct Cache *cache, uint64_t key) {
+    return (long) ((key * 0x9E3779B97F4A7C15ULL) >> cache->shift);
+}
+
+// look up a key, returns 0 if no value is stored yet
+static int lookup(const struct Cache *cache, uint64_t key, double *value) {
+    for (long i = hash(cache, key);; i = (i + 1) & (cache->capacity - 1)) {
+        uint64_t k = atomic_load_explicit(&(cache->slot[i].key), memory_order_acquire);
+        if (k == key) {
+            uint64_t v = atomic_load_explicit(&(cache->slot[i].value), memory_order_acquire);
+            if (v == UNSET) {
+                return 0;
+            }
+            memcpy(value, &v, sizeof(double));
+            return 1;
+        }
+        if (k == 0) {
+            return 0;
+        }
+    }
+}
+
+// store a value unless the table is too full; another thread may store the same key at once
+static void insert(struct Cache *cache, uint64_t key, double value) {
+    uint64_t v;
+    memcpy(&v, &value, sizeof(double));
+    for (long i = hash(cache, key);; i = (i + 1) & (cache->capacity - 1)) {
+        uint64_t k = atomic_load_explicit(&(cache->slot[i].key), memory_order_acquire);
+        if (k == 0) {
+            if (4 * atomic_load_explicit(&(cache->count), memory_order_relaxed) >= 3 * cache->capacity) {
+                return;
+            }
+            if (atomic_compare_exchange_strong(&(cache->slot[i].key), &k, key)) {
+                atomic_fetch_add_explicit(&(cache->count), 1, memory_order_relaxed);
+                k = key;
+            }
+        }
+        if (k == key) {
+            atomic_store_explicit(&(cache->slot[i].value), v, memory_order_release);
+            return;
+        }
+    }
+}
+
+// old table contents are reinserted into one with at least n slots (single-threaded)
+static void grow(struct Cache *cache, long n) {
+    struct Slot *old = cache->slot;
+    long old_capacity = cache->capacity;
+
+    new_table(cache, n);
+    for (long i = 0; i < old_capacity; i++) {
+        uint64_t k = atomic_load(&(old[i].key));
+        uint64_t v = atomic_load(&(old[i].value));
+        if (k != 0 && v != UNSET) {
+            double value;
+            memcpy(&value, &v, sizeof(double));
+            insert(cache, k, value);
+        }
+    }
+    free(old);
+}
+
+struct Cache *cache_create(const char *key, double a, double b, long capacity) {
+    if (strlen(key) >= CACHEKEY) {
+        printf("Cache key %s is longer than %d characters - exiting\n", key, CACHEKEY - 1);
+        exit(1);
+    }
+    struct Cache *cache = malloc(sizeof(struct Cache));
+    if (cache == NULL) {
+        printf("Unable to allocate cache - exiting\n");
+        exit(1);
+    }
+    memset(cache->key, 0, CACHEKEY);
+    strcpy(cache->key, key);
+    cache->a = a;
+    cache->b = b;
+    cache->func = NULL;
+    cache->batch_func = NULL;
+    new_table(cache, 2 * capacity);
+    return cache;
+}
+
+long cache_count(const struct Cache *cache) {
+    return atomic_load(&(cache->count));
+}
+
+void cache_free(struct Cache *cache) {
+    free(cache->slot);
+    free(cache);
+}
+
+// File layout: magic, integrand key, a, b, number of entries, then (position, value bits) pairs
+void cache_save(const struct Cache *cache, const char *path) {
+    FILE *file = fopen(path, "wb");
+    long count = 0;
+    if (file == NULL) {
+        printf("Unable to open %s - exiting\n", path);
+        exit(1);
+    }
+    for (long i = 0; i < cache->capacity; i++) {
+        if (atomic_load(&(cache->slot[i].key)) != 0 && atomic_load(&(cache->slot[i].value)) != UNSET) {
+            count++;
+        }
+    }
+    int ok = fwrite(magic, sizeof(magic), 1, file) == 1 && fwrite(cache->key, CACHEKEY, 1, file) == 1
+             && fwrite(&(cache->a), sizeof(double), 1, file) == 1
+             && fwrite(&(cache->b), sizeof(double), 1, file) == 1 && fwrite(&count, sizeof(long), 1, file) == 1;
+    for (long i = 0; ok && i < cache->capacity; i++) {
+        uint64_t entry[2] = {atomic_load(&(cache->slot[i].key)), atomic_load(&(cache->slot[i].value))};
+        if (entry[0] != 0 && entry[1] != UNSET) {
+            ok = fwrite(entry, sizeof(entry), 1, file) == 1;
+        }
+    }
+    if (fclose(file) != 0 || !ok) {
+        printf("Unable to write %s - exiting\n", path);
+        exit(1);
+    }
+}
+
+struct Cache *cache_load(const char *path, const char *key) {
+    FILE *file = fopen(path, "rb");
+    char tag[sizeof(magic)], stored[CACHEKEY];
+    double a, b;
+    long count;
+
+    if (file == NULL) {
+        return NULL;
+    }
+    if (fread(tag, sizeof(tag), 1, file) != 1 || memcmp(tag, magic, sizeof(magic)) != 0
+        || fread(stored, CACHEKEY, 1, file) != 1 || stored[CACHEKEY - 1] != '\0'
+        || fread(&a, sizeof(double), 1, file) != 1 || fread(&b, sizeof(double), 1, file) != 1
+        || fread(&count, sizeof(long), 1, file) != 1 || count < 0) {
+        printf("%s is not a cache file - exiting\n", path);
+        exit(1);
+    }
+    // Values of a different integrand would be reused silently
+    if (strcmp(stored, key) != 0) {
+        printf("%s caches integrand %s, not %s - exiting\n", path, stored, key);
+        exit(1);
+    }
+    struct Cache *cache = cache_create(key, a, b, count);
+    for (long i = 0; i < count; i++) {
+        uint64_t entry[2];
+        double value;
+        if (fread(entry, sizeof(entry), 1, file) != 1 || entry[0] == 0) {
+            printf("%s is truncated - exiting\n", path);
+            exit(1);
+        }
+        memcpy(&value, &entry[1], sizeof(double));
+        insert(cache, entry[0], value);
+    }
+    fclose(file);
+    return cache;
+}
+
+// integrand looked up in this thread's active cache
+static double cached_func(double x) {
+    uint64_t key = key_of(active, x);
+    double value;
+    if (key != 0 && lookup(active, key, &value)) {
+        return value;
+    }
+    value = active->func(x);
+    if (key != 0) {
+        insert(active, key, value);
+    }
+    return value;
+}
+
+// batch integrand looked up in this thread's active cache; the misses of each chunk are evaluated in one call
+static void cached_batch(const double *x, double *y, int n) {
+    for (int i = 0; i < n; i += CACHECHUNK) {
+        int m = (n - i < CACHECHUNK) ? n - i : CACHECHUNK;
+        double xm[CACHECHUNK], ym[CACHECHUNK];
+        uint64_t key[CACHECHUNK];
+        int where[CACHECHUNK], misses = 0;
+
+        for (int j = 0; j < m; j++) {
+            key[j] = key_of(active, x[i + j]);
+            if (key[j] == 0 || !lookup(active, key[j], &y[i + j])) {
+                where[misses] = j;
+                xm[misses++] = x[i + j];
+            }
+        }
+        if (misses > 0) {
+            active->batch_func(xm, ym, misses);
+        }
+        for (int j = 0; j < misses; j++) {
+            y[i + where[j]] = ym[j];
+            if (key[where[j]] != 0) {
+                insert(active, key[where[j]], ym[j]);
+            }
+        }
+    }
+}
+
+double (*cache_bind(struct Cache *cache, double (*func)(double), struct Options *opts, double a, double b))(double) {
+    if (a != cache->a || b != cache->b) {
+        printf("Cache is for [%g, %g], not [%g, %g] - exiting\n", cache->a, cache->b, a, b);
+        exit(1);
+    }
+    // Leave room for a run at a tighter tolerance to store about as many values again
+    if (4 * cache_count(cache) > cache->capacity) {
+        grow(cache, 4 * cache_count(cache));
+    }
+    cache->func = func;
+    cache->batch_func = opts->batch_func;
+    if (opts->batch_func != NULL) {
+        opts->batch_func = cached_batch;
+    }
+    return cached_func;
+}
+
+struct Cache *cache_enter(struct Cache *cache) {
+    struct Cache *previous = active;
+    active = cache;
+    return previous;
+}
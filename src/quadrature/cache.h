@@ -0,0 +1,36 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+// Opt-in memoisation of integrand values for reruns over the same domain.
+// Every abscissa visited by bisecting [a, b] is a dyadic point
+// a + (b - a) * index / 2^level with index odd, so values are stored under
+// (level, index) in a concurrent open-addressing hash map, independent of
+// the tolerance and strategy that produced them. A run at a tighter
+// tolerance then only evaluates the points below the old tree's leaves.
+// Set Options.cache to use one with integrate(); concurrent calls may use
+// different caches, but calls sharing a cache must not overlap. Positions say
+// nothing about the integrand, so each cache carries a key naming it, which
+// cache_load() checks. The table is grown between runs only: once it is three
+// quarters full during a run, new values are evaluated but no longer stored.
+
+#define CACHEKEY 32 // longest key, including the terminating NUL
+
+struct Cache;
+
+// empty cache for integrand key over [a, b], sized for about capacity values
+struct Cache *cache_create(const char *key, double a, double b, long capacity);
+
+// read a cache written by cache_save() for integrand key, returns NULL if the
+// file cannot be opened and exits if it was saved for another integrand
+struct Cache *cache_load(const char *path, const char *key);
+
+// write every stored value to path
+void cache_save(const struct Cache *cache, const char *path);
+
+// number of stored values
+long cache_count(const struct Cache *cache);
+
+// release a cache
+void cache_free(struct Cache *cache);
+
+#endif
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
+#include "level.h"
+#include "probe.h"
+
+// A checkpoint file is a Record header, the five arrays of the frontier in
+// turn and an end tag. Each checkpoint is written to path.tmp and renamed
+// over path, so the file only ever holds one record and a run killed while
+// writing leaves the previous checkpoint intact. Files from older versions,
+// which appended records, are still read: resuming takes the last record
+// whose end tag is present.
+
+static const char begin_tag[8] = "QCKPT1";
+static const char end_tag[8] = "QCKEND";
+
+// fixed part of a checkpoint record
+struct Record {
+    char tag[8];   // begin_tag
+    double tol;    // tolerance of the run
+    double sum;    // sum over the intervals converged so far
+    long count;    // number of intervals in the frontier
+};
+
+void write_checkpoint(const char *path, double tol, double sum, const struct Level *level) {
+    char *temp = malloc(strlen(path) + 5);
+    struct Record record;
+
+    if (temp == NULL) {
+        printf("Unable to allocate checkpoint path - exiting\n");
+        exit(1);
+    }
+    strcpy(temp, path);
+    strcat(temp, ".tmp");
+    FILE *file = fopen(temp, "wb");
+    if (file == NULL) {
+        printf("Unable to open %s - exiting\n", temp);
+        exit(1);
+    }
+    memcpy(record.tag, begin_tag, sizeof(begin_tag));
+    record.tol = tol;
+    record.sum = sum;
+    record.count = level->count;
+
+    int ok = fwrite(&record, sizeof(record), 1, file) == 1;
+    const double *field[5] = {level->left, level->right, level->f_left, level->f_mid, level->f_right};
+    for (int k = 0; ok && k < 5; k++) {
+        ok = fwrite(field[k], sizeof(double), level->count, file) == (size_t) level->count;
+    }
+    ok = ok && fwrite(end_tag, sizeof(end_tag), 1, file) == 1;
+    // The record must be on disk before it replaces the previous one
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (fclose(file) != 0 || !ok) {
+        printf("Unable to write %s - exiting\n", temp);
+        exit(1);
+    }
+    if (rename(temp, path) != 0) {
+        printf("Unable to replace %s - exiting\n", path);
+        exit(1);
+    }
+    free(temp);
+}
+
+double integrate_resume(double (*func)(double), const char *path, const struct Options *opts) {
+    struct Options defaults;
+    struct Level start = {0};
+    struct stat info;
+
+    if (opts == NULL) {
+        default_options(&defaults);
+        opts = &defaults;
+    }
+    int num_threads = (opts->num_threads > 0) ? opts->num_threads : omp_get_max_threads();
+    if (opts->rule != RULE_SIMPSON) {
+        printf("Rule %s is not supported by resume - exiting\n", rule_name(opts->rule));
+        exit(1);
+    }
+    if (opts->budget != NULL || opts->progress != NULL || opts->cache != NULL) {
+        printf("Budgets, progress and caches are not supported by resume - exiting\n");
+        exit(1);
+    }
+
+    // Map the file and find the last complete record
+    int fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0) {
+        printf("Unable to read %s - exiting\n", path);
+        exit(1);
+    }
+    size_t size = info.st_size;
+    const char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        printf("Unable to map %s - exiting\n", path);
+        exit(1);
+    }
+    close(fd);
+
+    const struct Record *last = NULL;
+    size_t offset = 0;
+    while (offset + sizeof(struct Record) + sizeof(end_tag) <= size) {
+        const struct Record *record = (const struct Record *) (data + offset);
+        // Check the count against the bytes left before using it, so a
+        // corrupt count cannot overflow the length or read past the mapping
+        size_t room = (size - offset - sizeof(struct Record) - sizeof(end_tag)) / (5 * sizeof(double));
+        if (memcmp(record->tag, begin_tag, sizeof(begin_tag)) != 0 || record->count < 0
+            || (size_t) record->count > room) {
+            break;
+        }
+        size_t length = sizeof(struct Record) + 5 * (size_t) record->count * sizeof(double) + sizeof(end_tag);
+        if (memcmp(data + offset + length - sizeof(end_tag), end_tag, sizeof(end_tag)) != 0) {
+            // partly written record from a run that was stopped
+            break;
+        }
+        last = record;
+        offset += length;
+    }
+    if (last == NULL) {
+        printf("%s holds no complete checkpoint - exiting\n", path);
+        exit(1);
+    }
+
+    // Reload the frontier
+    const double *values = (const double *) (last + 1);
+    reserve_level(&start, last->count);
+    double *field[5] = {start.left, start.right, start.f_left, start.f_mid, start.f_right};
+    for (int k = 0; k < 5; k++) {
+        memcpy(field[k], values + k * last->count, last->count * sizeof(double));
+    }
+    start.count = last->count;
+    double tol = last->tol, sum = last->sum;
+    munmap((void *) data, size);
+
+    double begin = 0.0;
+    if (opts->stats != NULL) {
+        stats_begin(opts->stats, num_threads);
+        begin = omp_get_wtime();
+    }
+    if (opts->trace != NULL) {
+        trace_begin(opts->trace, num_threads);
+    }
+
+    if (start.count == 0) {
+        // the run had already finished
+        free_level(&start);
+        return sum;
+    }
+
+    double quad = refine_levels(func, &start, sum, tol, opts, num_threads, NULL, NULL);
+    if (opts->stats != NULL) {
+        opts->stats->time = omp_get_wtime() - begin;
+    }
+    return quad;
+}
@@ -0,0 +1,328 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <omp.h>
+#include "accumulator.h"
+#include "backoff.h"
+#include "cubature.h"
+#include "probe.h"
+#include "records.h"
+
+// Genz-Malik rule, as laid out in A. C. Genz and A. A. Malik, "An adaptive
+// algorithm for numerical integration over an N-dimensional rectangular
+// region", J. Comput. Appl. Math. 6 (1980). Points are the centre, +-lambda2
+// and +-lambda4 along each axis, +-lambda4 along each pair of axes, and the
+// 2^dim corners at +-lambda5, in units of the box half-widths.
+static const double lambda2 = 0.35856858280031809199; // sqrt(9 / 70)
+static const double lambda4 = 0.94868329805051379960; // sqrt(9 / 10)
+static const double lambda5 = 0.68824720161168529772; // sqrt(9 / 19)
+
+// pending box
+struct Box {
+    double centre[CUBATURE_MAXDIM]; // centre of the box
+    double half[CUBATURE_MAXDIM];   // half-width along each axis
+    double tol;                     // tolerance
+};
+
+// state shared by every thread or task of one cubature
+struct Cubature {
+    double (*func)(const double *, int); // integrand
+    int dim;                             // number of dimensions
+    long points;                         // integrand calls per box
+    struct Stats *stats;                 // per-thread counters, or NULL
+    int pending;                         // tasks created but not yet started (STRATEGY_RECURSIVE)
+    int max_pending;                     // cutoff above which no new tasks are created
+};
+
+// Apply the rule to box, returning the degree 7 estimate. *err is set to
+// its difference from the degree 5 estimate and *axis to the axis to split.
+static double genz_malik(const struct Cubature *state, const struct Box *box, double *err, int *axis) {
+    int n = state->dim;
+    double x[CUBATURE_MAXDIM] = {0.0};
+    double volume = 1.0;
+    double sum2 = 0.0, sum3 = 0.0, sum4 = 0.0, sum5 = 0.0;
+    double widest = 0.0, largest = -1.0;
+
+    for (int i = 0; i < n; i++) {
+        x[i] = box->centre[i];
+        volume *= 2.0 * box->half[i];
+    }
+    double f0 = state->func(x, n);
+
+    // Points along each axis; their fourth difference picks the axis to split
+    for (int i = 0; i < n; i++) {
+        double c = box->centre[i], h = box->half[i];
+        x[i] = c - lambda2 * h;
+        double f2 = state->func(x, n);
+        x[i] = c + lambda2 * h;
+        f2 += state->func(x, n);
+        x[i] = c - lambda4 * h;
+        double f3 = state->func(x, n);
+        x[i] = c + lambda4 * h;
+        f3 += state->func(x, n);
+        x[i] = c;
+        sum2 += f2;
+        sum3 += f3;
+
+        double diff = fabs(f2 - 2.0 * f0 - (lambda2 * lambda2) / (lambda4 * lambda4) * (f3 - 2.0 * f0));
+        if (diff > largest || (diff == largest && h > widest)) {
+            largest = diff;
+            widest = h;
+            *axis = i;
+        }
+    }
+
+    // Points along each pair of axes
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            for (int s = 0; s < 4; s++) {
+                x[i] = box->centre[i] + ((s & 1) ? lambda4 : -lambda4) * box->half[i];
+                x[j] = box->centre[j] + ((s & 2) ? lambda4 : -lambda4) * box->half[j];
+                sum4 += state->func(x, n);
+            }
+            x[i] = box->centre[i];
+            x[j] = box->centre[j];
+        }
+    }
+
+    // Corners, visited in Gray code order so that one coordinate changes per point
+    for (int i = 0; i < n; i++) {
+        x[i] = box->centre[i] - lambda5 * box->half[i];
+    }
+    sum5 = state->func(x, n);
+    for (long k = 1; k < (1L << n); k++) {
+        int i = __builtin_ctzl(k);
+        x[i] = 2.0 * box->centre[i] - x[i];
+        sum5 += state->func(x, n);
+    }
+
+    double w = (double) n;
+    double q7 = (12824.0 - 9120.0 * w + 400.0 * w * w) / 19683.0 * f0 + 980.0 / 6561.0 * sum2
+              + (1820.0 - 400.0 * w) / 19683.0 * sum3 + 200.0 / 19683.0 * sum4
+              + 6859.0 / 19683.0 / (double) (1L << n) * sum5;
+    double q5 = (729.0 - 950.0 * w + 50.0 * w * w) / 729.0 * f0 + 245.0 / 486.0 * sum2
+              + (265.0 - 100.0 * w) / 1458.0 * sum3 + 25.0 / 729.0 * sum4;
+
+    *err = fabs(q7 - q5) * volume;
+    return q7 * volume;
+}
+
+// whether box is converged or too small to split further
+static int converged(const struct Box *box, int dim, double err) {
+    double widest = 0.0;
+    for (int i = 0; i < dim; i++) {
+        widest = (box->half[i] > widest) ? box->half[i] : widest;
+    }
+    return (err < box->tol) || (widest < 0.5e-12);
+}
+
+// split box in two along axis
+static void split(const struct Box *box, int axis, struct Box *b1, struct Box *b2) {
+    *b1 = *box;
+    *b2 = *box;
+    b1->half[axis] = b2->half[axis] = box->half[axis] / 2.0;
+    b1->centre[axis] = box->centre[axis] - box->half[axis] / 2.0;
+    b2->centre[axis] = box->centre[axis] + box->half[axis] / 2.0;
+}
+
+// integral over box by recursive bisection, with tasks while fewer than max_pending are queued
+static double recurse(struct Cubature *state, struct Box box) {
+    struct ThreadStats *st = thread_stats(state->stats, omp_get_thread_num());
+    double err;
+    int axis = 0;
+    double t = probe_start(st);
+    double quad = genz_malik(state, &box, &err, &axis);
+    probe_eval(st, state->points, t);
+    probe_intervals(st, 1);
+
+    if (converged(&box, state->dim, err)) {
+        return quad;
+    }
+
+    struct Box b1, b2;
+    double quad1, quad2;
+    int queued;
+    split(&box, axis, &b1, &b2);
+
+    #pragma omp atomic read
+    queued = state->pending;
+
+    if (queued < state->max_pending) {
+        // Idle threads may be waiting for work, so create OpenMP tasks
+        #pragma omp atomic
+        state->pending += 2;
+        probe_tasks(st, 2);
+        probe_depth(st, queued + 2);
+
+        #pragma omp task shared(quad1)
+        {
+            #pragma omp atomic
+            state->pending--;
+            quad1 = recurse(state, b1);
+        }
+
+        #pragma omp task shared(quad2)
+        {
+            #pragma omp atomic
+            state->pending--;
+            quad2 = recurse(state, b2);
+        }
+
+        #pragma omp taskwait
+    } else {
+        quad1 = recurse(state, b1);
+        quad2 = recurse(state, b2);
+    }
+    return quad1 + quad2;
+}
+
+// Boxes on one shared stack, or one stack per thread with stealing
+static double stacks(struct Cubature *state, const struct Box *whole, int shared, int num_threads) {
+    int num_stacks = shared ? 1 : num_threads;
+    struct RecordStack *stack = malloc(num_stacks * sizeof(struct RecordStack));
+    struct Accumulator *acc = new_accumulators(num_threads);
+    _Atomic long outstanding = 1; // boxes that are queued or currently being processed
+
+    if (stack == NULL) {
+        printf("Unable to allocate queue storage - exiting\n");
+        exit(1);
+    }
+    for (int k = 0; k < num_stacks; k++) {
+        records_init(&stack[k], sizeof(struct Box));
+    }
+    records_push(&stack[0], whole, NULL);
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int id = omp_get_thread_num();
+        int team = omp_get_num_threads(); // may be fewer than requested
+        struct RecordStack *own = &stack[shared ? 0 : id];
+        struct ThreadStats *st = thread_stats(state->stats, id);
+        int victim = id;
+        int delay = 1; // idle spin, see backoff()
+
+        while (1) {
+            struct Box box;
+            double t = probe_start(st);
+            int found = records_pop(own, &box, 1, st);
+
+            // Own stack is empty, take the largest box from the other threads in turn
+            for (int k = 1; !found && !shared && k < team; k++) {
+                victim = (victim + 1) % team;
+                if (victim != id) {
+                    found = records_pop(&stack[victim], &box, 0, st);
+                }
+            }
+
+            if (!found) {
+                // No work anywhere we looked - finished only if nothing is outstanding,
+                // otherwise wait a while before looking again
+                if (atomic_load(&outstanding) == 0) {
+                    probe_idle(st, t);
+                    break;
+                }
+                backoff(&delay);
+                probe_idle(st, t);
+                continue;
+            }
+            delay = 1;
+
+            double err;
+            int axis = 0;
+            t = probe_start(st);
+            double quad = genz_malik(state, &box, &err, &axis);
+            probe_eval(st, state->points, t);
+            probe_intervals(st, 1);
+
+            if (converged(&box, state->dim, err)) {
+                // Tolerance is met, add to this thread's total; boxes can share
+                // this position, and reduce() breaks the tie on the value
+                accumulate(&acc[id], box.centre[0] - box.half[0], quad);
+                atomic_fetch_sub(&outstanding, 1);
+            } else {
+                // Tolerance is not met, split box in two and push both halves
+                struct Box b1, b2;
+                split(&box, axis, &b1, &b2);
+
+                // one box consumed, two added
+                atomic_fetch_add(&outstanding, 1);
+                records_push(own, &b2, st);
+                records_push(own, &b1, st);
+            }
+        }
+    }
+
+    for (int k = 0; k < num_stacks; k++) {
+        records_destroy(&stack[k]);
+    }
+    free(stack);
+    return reduce(acc, num_threads);
+}
+
+double integrate_cubature(double (*func)(const double *x, int dim), int dim, const double *a, const double *b,
+                          double tol, const struct Options *opts) {
+    struct Options defaults;
+    struct Cubature state;
+    struct Box whole;
+
+    if (opts == NULL) {
+        default_options(&defaults);
+        opts = &defaults;
+    }
+    if (dim < 2 || dim > CUBATURE_MAXDIM) {
+        printf("Cubature needs 2 to %d dimensions, not %d - exiting\n", CUBATURE_MAXDIM, dim);
+        exit(1);
+    }
+    int num_threads = (opts->num_threads > 0) ? opts->num_threads : omp_get_max_threads();
+    if (opts->strategy == STRATEGY_SERIAL) {
+        num_threads = 1;
+    }
+
+    state.func = func;
+    state.dim = dim;
+    state.points = 1 + 4 * dim + 2 * dim * (dim - 1) + (1L << dim);
+    state.stats = opts->stats;
+    state.pending = 0;
+
+    for (int i = 0; i < dim; i++) {
+        whole.centre[i] = (a[i] + b[i]) / 2.0;
+        whole.half[i] = (b[i] - a[i]) / 2.0;
+    }
+    whole.tol = tol;
+
+    double start = 0.0;
+    if (opts->stats != NULL) {
+        stats_begin(opts->stats, num_threads);
+        start = omp_get_wtime();
+    }
+
+    double quad = 0.0;
+    switch (opts->strategy) {
+    case STRATEGY_SERIAL:
+    case STRATEGY_LIFO:
+        quad = stacks(&state, &whole, 1, num_threads);
+        break;
+    case STRATEGY_WORK_STEALING:
+        quad = stacks(&state, &whole, 0, num_threads);
+        break;
+    case STRATEGY_RECURSIVE:
+        #pragma omp parallel num_threads(num_threads)
+        {
+            #pragma omp single
+            {
+                state.max_pending = opts->tasks_per_thread * omp_get_num_threads();
+                quad = recurse(&state, whole);
+            }
+        }
+        break;
+    default:
+        printf("Strategy %s is not supported for cubature - exiting\n", strategy_name(opts->strategy));
+        exit(1);
+    }
+
+    if (opts->stats != NULL) {
+        opts->stats->time = omp_get_wtime() - start;
+    }
+    return quad;
+}
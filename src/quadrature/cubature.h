@@ -0,0 +1,22 @@
+#ifndef CUBATURE_H
+#define CUBATURE_H
+
+#include "quadrature.h"
+
+// Adaptive cubature over a hyper-rectangle in 2 to CUBATURE_MAXDIM dimensions.
+// Each box is estimated with the Genz-Malik degree 7 rule, with its
+// embedded degree 5 rule as the error estimate. A box that misses the
+// tolerance is halved along the axis with the largest fourth difference,
+// so the subdivision follows the integrand rather than nesting 1-D solves.
+
+#define CUBATURE_MAXDIM 10 // the rule takes 2^dim + O(dim^2) points per box
+
+// integrate func(x) over the box a[i] <= x[i] <= b[i], i < dim
+// Boxes are scheduled by opts->strategy: STRATEGY_SERIAL, STRATEGY_RECURSIVE
+// (tasks), STRATEGY_LIFO (one shared stack) or STRATEGY_WORK_STEALING (one
+// stack per thread, stealing the largest boxes); the others are not supported.
+// opts->stats is filled in, counting boxes as intervals; opts may be NULL.
+double integrate_cubature(double (*func)(const double *x, int dim), int dim, const double *a, const double *b,
+                          double tol, const struct Options *opts);
+
+#endif
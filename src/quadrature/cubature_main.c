@@ -0,0 +1,61 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "cubature.h"
+#include "stats.h"
+
+// Gaussian over the unit cube, whose integral is (sqrt(pi) / 2 erf(1))^dim
+static double gaussian(const double *x, int dim) {
+    double r2 = 0.0;
+    for (int i = 0; i < dim; i++) {
+        r2 += x[i] * x[i];
+    }
+    return exp(-r2);
+}
+
+// usage: cubature [-s] [strategy] [dim [tol]]
+// -s prints per-thread stats
+int main(int argc, char **argv) {
+    struct Options opts;
+    double a[CUBATURE_MAXDIM], b[CUBATURE_MAXDIM];
+    int dim = 3;
+    double tol = 1e-06;
+
+    default_options(&opts);
+    if (argc > 1 && strcmp(argv[1], "-s") == 0) {
+        opts.stats = stats_create();
+        argc--;
+        argv++;
+    }
+    if (argc > 1 && !parse_strategy(argv[1], &opts.strategy)) {
+        printf("Unknown strategy %s\n", argv[1]);
+        return 1;
+    }
+    if (argc > 2) {
+        dim = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        tol = atof(argv[3]);
+    }
+    for (int i = 0; i < CUBATURE_MAXDIM; i++) {
+        a[i] = 0.0;
+        b[i] = 1.0;
+    }
+
+    double start = omp_get_wtime(); // Start the timer
+    double quad = integrate_cubature(gaussian, dim, a, b, tol, &opts);
+    double time = omp_get_wtime() - start; // Calculate the elapsed time
+
+    printf("Strategy = %s\n", strategy_name(opts.strategy));
+    printf("Dimensions = %d\n", dim);
+    printf("Result = %.12e\n", quad);
+    printf("Error = %.3e\n", fabs(quad - pow(sqrt(M_PI) / 2.0 * erf(1.0), dim)));
+    printf("Time(s) = %f\n", time);
+    if (opts.stats != NULL) {
+        stats_print(opts.stats, stdout);
+        stats_free(opts.stats);
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "deque.h"
+
+#define INITSIZE 1024
+
+// allocate a circular array with the given number of entries
+static struct Array *newarray(long size, struct Array *retired) {
+    struct Array *array = malloc(sizeof(struct Array));
+    if (array != NULL) {
+        array->entry = malloc(size * sizeof(struct Interval));
+    }
+    if (array == NULL || array->entry == NULL) {
+        printf("Unable to allocate queue storage - exiting\n");
+        exit(1);
+    }
+    array->size = size;
+    array->retired = retired;
+    return array;
+}
+
+// replace a full array with one twice the size (owner only)
+// The old array is kept alive because a thief may still be reading from it;
+// the new one is first touched by the owner, so it lands in local memory.
+static struct Array *grow(struct Deque *deque_p, struct Array *array, long top, long bottom) {
+    struct Array *bigger = newarray(2 * array->size, array);
+    for (long i = top; i < bottom; i++) {
+        bigger->entry[i % bigger->size] = array->entry[i % array->size];
+    }
+    atomic_store_explicit(&(deque_p->array), bigger, memory_order_release);
+    return bigger;
+}
+
+void deque_init(struct Deque *deque_p) {
+    atomic_init(&(deque_p->array), newarray(INITSIZE, NULL));
+    atomic_init(&(deque_p->top), 0);
+    atomic_init(&(deque_p->bottom), 0);
+}
+
+void deque_destroy(struct Deque *deque_p) {
+    struct Array *array = atomic_load(&(deque_p->array));
+    while (array != NULL) {
+        struct Array *retired = array->retired;
+        free(array->entry);
+        free(array);
+        array = retired;
+    }
+    atomic_store(&(deque_p->array), NULL);
+}
+
+void deque_push(struct Interval interval, struct Deque *deque_p) {
+    long b = atomic_load_explicit(&(deque_p->bottom), memory_order_relaxed);
+    long t = atomic_load_explicit(&(deque_p->top), memory_order_acquire);
+    struct Array *array = atomic_load_explicit(&(deque_p->array), memory_order_relaxed);
+    if (b - t >= array->size) {
+        array = grow(deque_p, array, t, b);
+    }
+    array->entry[b % array->size] = interval;
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&(deque_p->bottom), b + 1, memory_order_relaxed);
+}
+
+int deque_pop(struct Deque *deque_p, struct Interval *interval) {
+    long b = atomic_load_explicit(&(deque_p->bottom), memory_order_relaxed) - 1;
+    atomic_store_explicit(&(deque_p->bottom), b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&(deque_p->top), memory_order_relaxed);
+
+    if (t > b) {
+        // deque was already empty
+        atomic_store_explicit(&(deque_p->bottom), b + 1, memory_order_relaxed);
+        return 0;
+    }
+
+    struct Array *array = atomic_load_explicit(&(deque_p->array), memory_order_relaxed);
+    *interval = array->entry[b % array->size];
+    if (t == b) {
+        // last entry - race against thieves for it
+        int won = atomic_compare_exchange_strong_explicit(&(deque_p->top), &t, t + 1,
+                                                          memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&(deque_p->bottom), b + 1, memory_order_relaxed);
+        return won;
+    }
+    return 1;
+}
+
+int deque_steal(struct Deque *deque_p, struct Interval *interval) {
+    long t = atomic_load_explicit(&(deque_p->top), memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&(deque_p->bottom), memory_order_acquire);
+
+    if (t >= b) {
+        return 0;
+    }
+
+    struct Array *array = atomic_load_explicit(&(deque_p->array), memory_order_acquire);
+    *interval = array->entry[t % array->size];
+    return atomic_compare_exchange_strong_explicit(&(deque_p->top), &t, t + 1,
+                                                   memory_order_seq_cst, memory_order_relaxed);
+}
+
+long deque_size(struct Deque *deque_p) {
+    long b = atomic_load_explicit(&(deque_p->bottom), memory_order_relaxed);
+    long t = atomic_load_explicit(&(deque_p->top), memory_order_relaxed);
+    return (b > t) ? b - t : 0;
+}
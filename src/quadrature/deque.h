@@ -0,0 +1,44 @@
+#ifndef DEQUE_H
+#define DEQUE_H
+
+#include <stdatomic.h>
+#include "interval.h"
+
+// circular array backing a deque; replaced by one twice the size when full
+struct Array {
+    long size;                       // number of entries (power of two)
+    struct Interval *entry;          // circular array of deque entries
+    struct Array *retired;           // smaller array this one replaced
+};
+
+// Chase-Lev work-stealing deque, one per thread.
+// The owner pushes and pops at the bottom without locking; other threads
+// steal the oldest (and therefore widest) intervals from the top.
+struct Deque {
+    struct Array *_Atomic array;     // current storage
+    _Atomic long top;                // index of oldest entry (steal end)
+    char pad[64];                    // keep top and bottom on separate cache lines
+    _Atomic long bottom;             // index one past newest entry (owner end)
+};
+
+// initialise deque
+void deque_init(struct Deque *deque_p);
+
+// release deque storage
+void deque_destroy(struct Deque *deque_p);
+
+// add an interval at the owner end of the deque (owner only)
+void deque_push(struct Interval interval, struct Deque *deque_p);
+
+// take the newest interval from the owner end of the deque (owner only)
+// returns 0 if the deque is empty
+int deque_pop(struct Deque *deque_p, struct Interval *interval);
+
+// number of entries in the deque, approximate while other threads use it
+long deque_size(struct Deque *deque_p);
+
+// take the oldest interval from the steal end of another thread's deque
+// returns 0 if the deque is empty or another thread got there first
+int deque_steal(struct Deque *deque_p, struct Interval *interval);
+
+#endif
@@ -0,0 +1,14 @@
+// callable from OpenMP target regions as well as on the host
+#pragma omp declare target
+double euler(double, double, double, int); 
+
+double euler_closed(double, double, double);
+
+double func1(double);  
+#pragma omp end declare target
+
+void func1_batch(const double *, double *, int);
+
+void euler_vec(double, double, const double *, double *, int, int);
+
+void func1_vec(const double *, double *, int);
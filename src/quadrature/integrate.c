@@ -0,0 +1,205 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "probe.h"
+#include "solvers.h"
+
+static const char *names[NUM_STRATEGIES] = {
+    "serial",
+    "recursive",
+    "lifo",
+    "work-stealing",
+    "batched",
+    "priority",
+    "breadth-first",
+    "multi-queue"
+};
+
+static const char *rule_names[NUM_RULES] = {
+    "simpson",
+    "gk15",
+    "gk21"
+};
+
+void default_options(struct Options *opts) {
+    opts->strategy = STRATEGY_WORK_STEALING;
+    opts->rule = RULE_SIMPSON;
+    opts->num_threads = 0;
+    opts->numa = 0;
+    opts->tasks_per_thread = 4;
+    opts->batch_size = 8;
+    opts->queues_per_thread = 2;
+    opts->batch_func = NULL;
+    opts->cache = NULL;
+    opts->checkpoint = NULL;
+    opts->checkpoint_interval = 60.0;
+    opts->stats = NULL;
+    opts->trace = NULL;
+    opts->budget = NULL;
+    opts->progress = NULL;
+}
+
+const char *strategy_name(enum Strategy strategy) {
+    if (strategy < 0 || strategy >= NUM_STRATEGIES) {
+        return "unknown";
+    }
+    return names[strategy];
+}
+
+int parse_strategy(const char *name, enum Strategy *strategy) {
+    for (int i = 0; i < NUM_STRATEGIES; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *strategy = (enum Strategy) i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const char *rule_name(enum Rule rule) {
+    if (rule < 0 || rule >= NUM_RULES) {
+        return "unknown";
+    }
+    return rule_names[rule];
+}
+
+int parse_rule(const char *name, enum Rule *rule) {
+    for (int i = 0; i < NUM_RULES; i++) {
+        if (strcmp(name, rule_names[i]) == 0) {
+            *rule = (enum Rule) i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+struct Budget *budget_begin(struct Limits *limits, const struct Budget *budget, double a, double b, long evaluations) {
+    if (budget == NULL) {
+        return NULL;
+    }
+    limits->budget = *budget;
+    limits->budget.evaluations = evaluations;
+    limits->budget.error = 0.0;
+    limits->budget.exhausted = 0;
+    limits->deadline = omp_get_wtime() + budget->max_time;
+    // Between the widths at max_depth and one level up, so rounding cannot move the cut
+    limits->min_width = (budget->max_depth > 0) ? 1.5 * fabs(b - a) * ldexp(1.0, -budget->max_depth) : 0.0;
+    return &(limits->budget);
+}
+
+void budget_end(const struct Limits *limits, struct Budget *budget) {
+    if (budget == NULL) {
+        return;
+    }
+    budget->evaluations = limits->budget.evaluations;
+    budget->error = limits->budget.error;
+    budget->exhausted = limits->budget.exhausted;
+}
+
+double integrate(double (*func)(double), double a, double b, double tol, const struct Options *opts) {
+    struct Options defaults, run;
+    struct Limits limits;
+    struct Interval whole;
+
+    if (opts == NULL) {
+        default_options(&defaults);
+        opts = &defaults;
+    }
+    // The strategies are given a copy with the run's own budget and integrand
+    struct Budget *budget = opts->budget; // the caller's, where the usage is reported
+    run = *opts;
+    opts = &run;
+    if (run.cache != NULL) {
+        // Route every evaluation through the cache
+        func = cache_bind(run.cache, func, &run, a, b);
+    }
+    int num_threads = (opts->num_threads > 0) ? opts->num_threads : omp_get_max_threads();
+    int simpson = (opts->rule == RULE_SIMPSON);
+
+    if (!simpson && opts->strategy != STRATEGY_SERIAL && opts->strategy != STRATEGY_RECURSIVE
+        && opts->strategy != STRATEGY_LIFO && opts->strategy != STRATEGY_WORK_STEALING
+        && opts->strategy != STRATEGY_BATCHED && opts->strategy != STRATEGY_MULTI_QUEUE) {
+        printf("Rule %s is not supported by strategy %s - exiting\n", rule_name(opts->rule), strategy_name(opts->strategy));
+        exit(1);
+    }
+
+    if (opts->checkpoint != NULL && opts->strategy != STRATEGY_BREADTH_FIRST) {
+        printf("Checkpoints are not supported by strategy %s - exiting\n", strategy_name(opts->strategy));
+        exit(1);
+    }
+    if (opts->budget != NULL && opts->strategy == STRATEGY_BREADTH_FIRST) {
+        printf("Budgets are not supported by strategy %s - exiting\n", strategy_name(opts->strategy));
+        exit(1);
+    }
+    run.budget = budget_begin(&limits, budget, a, b, simpson ? 3 : 0);
+    if (opts->progress != NULL) {
+        if (opts->strategy == STRATEGY_PRIORITY || opts->strategy == STRATEGY_BREADTH_FIRST) {
+            printf("Progress is not supported by strategy %s - exiting\n", strategy_name(opts->strategy));
+            exit(1);
+        }
+        progress_begin(opts->progress, (opts->strategy == STRATEGY_SERIAL) ? 1 : num_threads, a, b);
+    }
+
+    double start = 0.0;
+    if (opts->stats != NULL) {
+        stats_begin(opts->stats, (opts->strategy == STRATEGY_SERIAL) ? 1 : num_threads);
+        start = omp_get_wtime();
+        opts->stats->thread[0].evaluations = simpson ? 3 : 0;
+    }
+    if (opts->trace != NULL) {
+        trace_begin(opts->trace, num_threads);
+    }
+
+    struct Cache *outer = cache_enter(opts->cache);
+
+    // Set up the initial interval; Gauss-Kronrod rules do not use the end and mid points
+    whole.left = a;
+    whole.right = b;
+    whole.tol = tol;
+    whole.f_left = simpson ? func(whole.left) : 0.0;
+    whole.f_right = simpson ? func(whole.right) : 0.0;
+    whole.f_mid = simpson ? func((whole.left + whole.right) / 2.0) : 0.0;
+    whole.share = 0.0;
+    whole.id = 0;
+
+    double quad;
+    switch (opts->strategy) {
+    case STRATEGY_SERIAL:
+        quad = integrate_serial(func, whole, opts);
+        break;
+    case STRATEGY_RECURSIVE:
+        quad = integrate_recursive(func, whole, opts, num_threads);
+        break;
+    case STRATEGY_LIFO:
+        quad = integrate_lifo(func, whole, opts, num_threads);
+        break;
+    case STRATEGY_WORK_STEALING:
+        quad = integrate_work_stealing(func, whole, opts, num_threads);
+        break;
+    case STRATEGY_BATCHED:
+        quad = integrate_batched(func, whole, opts, num_threads);
+        break;
+    case STRATEGY_PRIORITY:
+        quad = integrate_priority(func, whole, opts, num_threads);
+        break;
+    case STRATEGY_BREADTH_FIRST:
+        quad = integrate_breadth_first(func, whole, opts, num_threads);
+        break;
+    case STRATEGY_MULTI_QUEUE:
+        quad = integrate_multi_queue(func, whole, opts, num_threads);
+        break;
+    default:
+        printf("Unknown strategy %d - exiting\n", (int) opts->strategy);
+        exit(1);
+    }
+    // An integrand may itself call integrate() with another cache
+    cache_enter(outer);
+    budget_end(&limits, budget);
+
+    if (opts->stats != NULL) {
+        opts->stats->time = omp_get_wtime() - start;
+    }
+    return quad;
+}
@@ -0,0 +1,40 @@
+#ifndef INTERVAL_H
+#define INTERVAL_H
+
+struct Interval {
+    double left;    // left boundary
+    double right;   // right boundary
+    double tol;     // tolerance
+    double f_left;  // function value at left boundary
+    double f_mid;   // function value at midpoint
+    double f_right; // function value at right boundary
+    double share;   // half the parent's error estimate, 0 for a root (progress)
+    int id;         // problem the interval belongs to (integrate_many)
+};
+
+// split interval in two, setting up the halves from the values fd and fe
+// at its quarter points; each half inherits half of the error estimate err
+static inline void split_interval(const struct Interval *interval, double fd, double fe, double err,
+                                  struct Interval *i1, struct Interval *i2) {
+    double c = (interval->left + interval->right) / 2.0;
+
+    i1->left = interval->left;
+    i1->right = c;
+    i1->tol = interval->tol;
+    i1->f_left = interval->f_left;
+    i1->f_mid = fd;
+    i1->f_right = interval->f_mid;
+    i1->share = err / 2.0;
+    i1->id = interval->id;
+
+    i2->left = c;
+    i2->right = interval->right;
+    i2->tol = interval->tol;
+    i2->f_left = interval->f_mid;
+    i2->f_mid = fe;
+    i2->f_right = interval->f_right;
+    i2->share = err / 2.0;
+    i2->id = interval->id;
+}
+
+#endif
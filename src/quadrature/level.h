@@ -0,0 +1,39 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include "quadrature.h"
+
+// one level of the breadth-first frontier, structure-of-arrays
+struct Level {
+    long count;             // number of intervals
+    long capacity;          // allocated number of intervals
+    double *left;           // left boundaries
+    double *right;          // right boundaries
+    double *f_left;         // function values at left boundaries
+    double *f_mid;          // function values at midpoints
+    double *f_right;        // function values at right boundaries
+};
+
+// make room for at least n intervals in a level, keeping its contents
+void reserve_level(struct Level *level, long n);
+
+// release the storage of a level
+void free_level(struct Level *level);
+
+// Refine the intervals in start level by level until none are left, and
+// return base plus the sum over the converged intervals, where base is the
+// sum over intervals that converged before start was taken. start is
+// emptied and freed. If opts->checkpoint is set, the frontier and the sum
+// so far replace its contents between levels, at most every
+// opts->checkpoint_interval seconds, and once more when refinement ends.
+// If exchange is not NULL it is called on the master thread after each
+// level with the next frontier, may move intervals in or out of it, and
+// returns the number of intervals left anywhere; refinement stops when that
+// reaches zero. This lets several processes share one breadth-first run.
+double refine_levels(double (*func)(double), struct Level *start, double base, double tol, const struct Options *opts,
+                     int num_threads, long (*exchange)(struct Level *, void *), void *arg);
+
+// replace a checkpoint file with the frontier and the sum over converged intervals
+void write_checkpoint(const char *path, double tol, double sum, const struct Level *level);
+
+#endif
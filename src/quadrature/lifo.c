@@ -0,0 +1,267 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "accumulator.h"
+#include "backoff.h"
+#include "numa.h"
+#include "probe.h"
+#include "rule.h"
+#include "solvers.h"
+
+#define CHUNKSIZE 1024
+
+// fixed-size block of queue storage; chunks are linked into a stack
+struct Chunk {
+    struct Interval entry[CHUNKSIZE]; // array of chunk entries
+    struct Chunk *prev;               // chunk below this one in the stack
+};
+
+struct Queue {
+    struct Chunk *chunk;             // chunk holding the last entry
+    struct Chunk *spare;             // emptied chunks kept for reuse
+    int top;                         // index of last entry within chunk
+    int count;                       // total number of queue entries
+    omp_lock_t lock;                 // lock for synchronization
+    struct Trace *trace;             // timeline that queue operations are recorded in, or NULL
+};
+
+// state shared by every thread of one LIFO integration
+struct Lifo {
+    double (*func)(double);      // integrand
+    const struct GKRule *gk;     // Gauss-Kronrod pair, or NULL for Simpson's rule
+    struct Interval whole;       // root interval
+    struct Queue **queues;       // one queue per NUMA domain, or a single shared one
+    int num_queues;              // number of queues
+    struct Accumulator *acc;     // per-thread partial sums
+    int outstanding;             // intervals that are queued or currently being processed
+    struct Stats *stats;         // per-thread counters, or NULL
+    struct Trace *trace;         // per-thread event timeline, or NULL
+    struct Budget *budget;       // limits on the run, or NULL
+    struct Progress *progress;   // progressive results, or NULL
+    struct Cache *cache;         // integrand values kept between runs, or NULL
+};
+
+// add an interval to the queue
+static void enqueue(struct Interval interval, struct Queue *queue_p, struct ThreadStats *st, struct TraceBuffer *tb) {
+    double t = probe_start(st), start = trace_start(tb);
+    omp_set_lock(&(queue_p->lock));
+    probe_lock(st, t);
+    trace_span(tb, queue_p->trace, "lock", start);
+    if (queue_p->chunk == NULL || queue_p->top == CHUNKSIZE - 1) {
+        // Current chunk is full, reuse a spare one or allocate a new one.
+        // A new chunk is first touched by the thread that needs it, so it
+        // is placed in that thread's local memory.
+        struct Chunk *chunk = queue_p->spare;
+        if (chunk != NULL) {
+            queue_p->spare = chunk->prev;
+        } else {
+            chunk = malloc(sizeof(struct Chunk));
+            if (chunk == NULL) {
+                printf("Unable to allocate queue storage - exiting\n");
+                exit(1);
+            }
+        }
+        chunk->prev = queue_p->chunk;
+        queue_p->chunk = chunk;
+        queue_p->top = -1;
+    }
+    queue_p->top++;
+    queue_p->count++;
+    queue_p->chunk->entry[queue_p->top] = interval;
+    probe_depth(st, queue_p->count);
+    omp_unset_lock(&(queue_p->lock));
+    trace_span(tb, queue_p->trace, "enqueue", start);
+}
+
+// extract last interval from queue
+// returns 0 if the queue is empty
+static int dequeue(struct Queue *queue_p, struct Interval *interval, struct ThreadStats *st, struct TraceBuffer *tb) {
+    double t = probe_start(st), start = trace_start(tb);
+    omp_set_lock(&(queue_p->lock));
+    probe_lock(st, t);
+    trace_span(tb, queue_p->trace, "lock", start);
+    if (queue_p->count == 0) {
+        omp_unset_lock(&(queue_p->lock));
+        return 0;
+    }
+
+    *interval = queue_p->chunk->entry[queue_p->top];
+    queue_p->top--;
+    queue_p->count--;
+    if (queue_p->top == -1 && queue_p->chunk->prev != NULL) {
+        // Chunk is now empty, move it to the spare list and drop back a chunk
+        struct Chunk *chunk = queue_p->chunk;
+        queue_p->chunk = chunk->prev;
+        queue_p->top = CHUNKSIZE - 1;
+        chunk->prev = queue_p->spare;
+        queue_p->spare = chunk;
+    }
+    omp_unset_lock(&(queue_p->lock));
+    trace_span(tb, queue_p->trace, "dequeue", start);
+    return 1;
+}
+
+// initialise queue
+static void init(struct Queue *queue_p) {
+    queue_p->chunk = NULL;
+    queue_p->spare = NULL;
+    queue_p->top = -1;
+    queue_p->count = 0;
+    queue_p->trace = NULL;
+    omp_init_lock(&(queue_p->lock));
+}
+
+// release queue storage
+static void destroy(struct Queue *queue_p) {
+    struct Chunk *lists[2] = {queue_p->chunk, queue_p->spare};
+    for (int i = 0; i < 2; i++) {
+        while (lists[i] != NULL) {
+            struct Chunk *prev = lists[i]->prev;
+            free(lists[i]);
+            lists[i] = prev;
+        }
+    }
+    omp_destroy_lock(&(queue_p->lock));
+}
+
+// work through the queues until no interval is outstanding, run by every thread
+static void worker(struct Lifo *state) {
+    int id = omp_get_thread_num();
+    int domain = (state->num_queues > 1) ? numa_domain(state->num_queues) : 0;
+    struct Accumulator *own = &(state->acc[id]);
+    struct ThreadStats *st = thread_stats(state->stats, id);
+    struct TraceBuffer *tb = thread_trace(state->trace, id);
+    const struct GKRule *gk = state->gk;
+
+    cache_enter(state->cache);
+
+    // The first thread to reach each domain allocates its queue, so the
+    // queue and its lock are placed in that domain's memory
+    #pragma omp critical
+    {
+        if (state->queues[domain] == NULL) {
+            state->queues[domain] = malloc(sizeof(struct Queue));
+            if (state->queues[domain] == NULL) {
+                printf("Unable to allocate queue storage - exiting\n");
+                exit(1);
+            }
+            init(state->queues[domain]);
+            state->queues[domain]->trace = state->trace;
+        }
+    }
+    struct Queue *home = state->queues[domain];
+    int delay = 1; // idle spin, see backoff()
+    if (id == 0) {
+        enqueue(state->whole, home, NULL, NULL);
+    }
+    #pragma omp barrier
+
+    while (1) {
+        struct Interval interval;
+        double t = probe_start(st);
+        int found = dequeue(home, &interval, st, tb);
+
+        // Own domain's queue is empty, try the other domains in turn
+        for (int k = 1; !found && k < state->num_queues; k++) {
+            struct Queue *other = state->queues[(domain + k) % state->num_queues];
+            found = (other != NULL) && dequeue(other, &interval, st, tb);
+        }
+        if (!found) {
+            // An empty queue only means we are finished once no other thread
+            // is still working on an interval that may be split further
+            int remaining;
+            #pragma omp atomic read
+            remaining = state->outstanding;
+            if (remaining == 0) {
+                probe_idle(st, t);
+                break;
+            }
+            backoff(&delay);
+            probe_idle(st, t);
+            continue;
+        }
+        delay = 1;
+        double h = interval.right - interval.left;
+        double c = (interval.left + interval.right) / 2.0;
+        double d = (interval.left + c) / 2.0;
+        double e = (c + interval.right) / 2.0;
+        double fd = 0.0, fe = 0.0, quad, err;
+        t = probe_start(st);
+        if (gk == NULL) {
+            // Calculate integral estimates using 3 and 5 points respectively
+            fd = state->func(d);
+            fe = state->func(e);
+            probe_eval(st, 2, t);
+            double q1 = h / 6.0 * (interval.f_left + 4.0 * interval.f_mid + interval.f_right);
+            double q2 = h / 12.0 * (interval.f_left + 4.0 * fd + 2.0 * interval.f_mid + 4.0 * fe + interval.f_right);
+            err = fabs(q2 - q1);
+            quad = q2 + (q2 - q1) / 15.0;
+        } else {
+            // Kronrod estimate, none of whose nodes are reused by the subintervals
+            quad = gk_apply(gk, state->func, interval.left, interval.right, &err);
+            probe_eval(st, 2 * gk->n + 1, t);
+        }
+        probe_intervals(st, 1);
+        budget_charge(state->budget, (gk == NULL) ? 2 : 2 * gk->n + 1);
+
+        if ((err < interval.tol) || (h < 1.0e-12) || budget_stop(state->budget, h, err)) {
+            // Tolerance is met or the budget is spent, add to this thread's total
+            accumulate(own, interval.left, quad);
+            progress_leaf(state->progress, id, h, quad, interval.share);
+            trace_instant(tb, state->trace, "leaf");
+            #pragma omp atomic
+            state->outstanding--;
+        } else {
+            // Tolerance is not met, split interval in two and add both halves to the queue
+            struct Interval i1, i2;
+            split_interval(&interval, fd, fe, err, &i1, &i2);
+            progress_split(state->progress, id, interval.share, err);
+
+            // one interval consumed, two added
+            #pragma omp atomic
+            state->outstanding++;
+            enqueue(i2, home, st, tb);
+            enqueue(i1, home, st, tb);
+        }
+    }
+}
+
+double integrate_lifo(double (*func)(double), struct Interval whole, const struct Options *opts, int num_threads) {
+    struct Lifo state;
+
+    state.func = func;
+    state.gk = gk_rule(opts->rule);
+    state.whole = whole;
+    state.num_queues = opts->numa ? numa_domains() : 1;
+    state.queues = calloc(state.num_queues, sizeof(struct Queue *));
+    state.acc = new_accumulators(num_threads);
+    state.outstanding = 1;
+    state.stats = opts->stats;
+    state.trace = opts->trace;
+    state.budget = opts->budget;
+    state.progress = opts->progress;
+    state.cache = opts->cache;
+    if (state.queues == NULL) {
+        printf("Unable to allocate queue storage - exiting\n");
+        exit(1);
+    }
+
+    // proc_bind cannot be chosen at run time, hence the two regions
+    if (opts->numa) {
+        #pragma omp parallel num_threads(num_threads) proc_bind(close)
+        worker(&state);
+    } else {
+        #pragma omp parallel num_threads(num_threads)
+        worker(&state);
+    }
+
+    for (int k = 0; k < state.num_queues; k++) {
+        if (state.queues[k] != NULL) {
+            destroy(state.queues[k]);
+            free(state.queues[k]);
+        }
+    }
+    free(state.queues);
+    return reduce(state.acc, num_threads);
+}
@@ -0,0 +1,210 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "cache.h"
+#include "function.h"
+#include "progress.h"
+#include "stats.h"
+#include "trace.h"
+#include "vector.h"
+#include "quadrature.h"
+
+// usage: integrate [-s|-j] [-t trace.json] [-r rule] [-n] [-e evals] [-w seconds] [-d depth]
+//                  [-p seconds] [strategy] [left right tol [cache-file [checkpoint-file]]]
+//        integrate resume checkpoint-file
+//        integrate vector n [strategy [left right tol]]
+// -s prints per-thread stats as a table, -j as JSON, -t writes a Chrome trace,
+// -r selects simpson, gk15 or gk21, -n turns on NUMA placement, -e, -w and -d
+// limit integrand calls, wall time and depth, -p prints intermediate results every
+// so many seconds; cache-file may be - for no cache
+#define MAXSWEEP 1024 // most components of the vector integrand
+
+// func1 with alpha scaled by (k + 1) / n, for each component k < n
+static void func1_sweep(double x, double *f, int n) {
+    double alpha[MAXSWEEP];
+    double base = 100000.0 * sin(x * 100000.0);
+    #pragma omp simd
+    for (int k = 0; k < n; k++) {
+        alpha[k] = base * (k + 1) / n;
+    }
+    euler_vec(0.0, 0.0001, alpha, f, n, 1000);
+}
+
+// print an intermediate estimate
+static void report(const struct Snapshot *snapshot, void *arg) {
+    (void) arg;
+    printf("Progress: %.3f s, %.1f%% converged, %ld leaves, partial = %e, pending error = %e\n",
+           snapshot->time, 100.0 * snapshot->covered, snapshot->leaves, snapshot->quad, snapshot->error);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    struct Options opts;
+    double left = 0.0, right = 10.0, tol = 1e-06;
+    int json = 0;
+    const char *trace = NULL;
+    struct Budget budget = {0};
+
+    default_options(&opts);
+    opts.batch_func = func1_vec;
+
+    while (argc > 1 && argv[1][0] == '-') {
+        if (strcmp(argv[1], "-s") == 0 || strcmp(argv[1], "-j") == 0) {
+            json = (argv[1][1] == 'j');
+            opts.stats = stats_create();
+        } else if (strcmp(argv[1], "-t") == 0 && argc > 2) {
+            trace = argv[2];
+            opts.trace = trace_create(1 << 20);
+            argc--;
+            argv++;
+        } else if ((strcmp(argv[1], "-e") == 0 || strcmp(argv[1], "-w") == 0 || strcmp(argv[1], "-d") == 0)
+                   && argc > 2) {
+            // Any of the three limits turns the budget on
+            if (argv[1][1] == 'e') {
+                budget.max_evaluations = atol(argv[2]);
+            } else if (argv[1][1] == 'w') {
+                budget.max_time = atof(argv[2]);
+            } else {
+                budget.max_depth = atoi(argv[2]);
+            }
+            opts.budget = &budget;
+            argc--;
+            argv++;
+        } else if (strcmp(argv[1], "-p") == 0 && argc > 2) {
+            opts.progress = progress_create(report, NULL, 0, atof(argv[2]));
+            argc--;
+            argv++;
+        } else if (strcmp(argv[1], "-n") == 0) {
+            opts.numa = 1;
+        } else if (strcmp(argv[1], "-r") == 0 && argc > 2) {
+            if (!parse_rule(argv[2], &opts.rule)) {
+                printf("Unknown rule %s\n", argv[2]);
+                return 1;
+            }
+            argc--;
+            argv++;
+        } else {
+            printf("Unknown option %s\n", argv[1]);
+            return 1;
+        }
+        argc--;
+        argv++;
+    }
+
+    if (argc > 2 && strcmp(argv[1], "vector") == 0) {
+        // All components of the sweep over one subdivision
+        int n = atoi(argv[2]);
+        double result[MAXSWEEP];
+        if (n < 1 || n > MAXSWEEP) {
+            printf("Vector length must be 1 to %d\n", MAXSWEEP);
+            return 1;
+        }
+        if (argc > 3 && !parse_strategy(argv[3], &opts.strategy)) {
+            printf("Unknown strategy %s\n", argv[3]);
+            return 1;
+        }
+        if (argc > 6) {
+            left = atof(argv[4]);
+            right = atof(argv[5]);
+            tol = atof(argv[6]);
+        }
+        double start = omp_get_wtime();
+        integrate_vector(func1_sweep, n, left, right, tol, result, &opts);
+        double time = omp_get_wtime() - start;
+        for (int k = 0; k < n; k++) {
+            printf("Result[%d] = %e\n", k, result[k]);
+        }
+        printf("Time(s) = %f\n", time);
+        if (opts.stats != NULL) {
+            if (json) {
+                stats_json(opts.stats, stdout);
+            } else {
+                stats_print(opts.stats, stdout);
+            }
+            stats_free(opts.stats);
+        }
+        return 0;
+    }
+
+    if (argc > 2 && strcmp(argv[1], "resume") == 0) {
+        // Carry on from the last checkpoint, still checkpointing to the same file
+        opts.checkpoint = argv[2];
+        double start = omp_get_wtime();
+        double quad = integrate_resume(func1, argv[2], &opts);
+        printf("Result = %e\n", quad);
+        printf("Time(s) = %f\n", omp_get_wtime() - start);
+        if (opts.stats != NULL) {
+            if (json) {
+                stats_json(opts.stats, stdout);
+            } else {
+                stats_print(opts.stats, stdout);
+            }
+            stats_free(opts.stats);
+        }
+        if (opts.trace != NULL) {
+            trace_write(opts.trace, trace);
+            trace_free(opts.trace);
+        }
+        return 0;
+    }
+
+    if (argc > 1 && !parse_strategy(argv[1], &opts.strategy)) {
+        printf("Unknown strategy %s, expected one of:", argv[1]);
+        for (int i = 0; i < NUM_STRATEGIES; i++) {
+            printf(" %s", strategy_name((enum Strategy) i));
+        }
+        printf("\n");
+        return 1;
+    }
+    if (argc > 4) {
+        left = atof(argv[2]);
+        right = atof(argv[3]);
+        tol = atof(argv[4]);
+    }
+    if (argc > 5 && strcmp(argv[5], "-") != 0) {
+        // Reuse the values saved by an earlier run over the same domain
+        opts.cache = cache_load(argv[5], "func1");
+        if (opts.cache == NULL) {
+            opts.cache = cache_create("func1", left, right, 1 << 20);
+        }
+        printf("Cached values = %ld\n", cache_count(opts.cache));
+    }
+    if (argc > 6) {
+        opts.checkpoint = argv[6];
+    }
+
+    double start = omp_get_wtime(); // Start the timer
+    double quad = integrate(func1, left, right, tol, &opts);
+    double time = omp_get_wtime() - start; // Calculate the elapsed time
+
+    printf("Strategy = %s\n", strategy_name(opts.strategy));
+    printf("Rule = %s\n", rule_name(opts.rule));
+    printf("Result = %e\n", quad);
+    printf("Time(s) = %f\n", time);
+    if (opts.budget != NULL) {
+        printf("Evaluations = %ld\n", budget.evaluations);
+        printf("Budget %s, estimated unconverged error = %e\n", budget.exhausted ? "exhausted" : "not reached", budget.error);
+    }
+
+    if (opts.stats != NULL) {
+        if (json) {
+            stats_json(opts.stats, stdout);
+        } else {
+            stats_print(opts.stats, stdout);
+        }
+        stats_free(opts.stats);
+    }
+    progress_free(opts.progress);
+    if (opts.trace != NULL) {
+        trace_write(opts.trace, trace);
+        trace_free(opts.trace);
+    }
+    if (opts.cache != NULL) {
+        printf("Cached values = %ld\n", cache_count(opts.cache));
+        cache_save(opts.cache, argv[5]);
+        cache_free(opts.cache);
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "backoff.h"
+#include "deque.h"
+#include "solvers.h"
+
+void integrate_many(double (*func)(double, double), const struct Problem *problems, double *results, int n,
+                    const struct Options *opts) {
+    struct Options defaults;
+
+    if (opts == NULL) {
+        default_options(&defaults);
+        opts = &defaults;
+    }
+    int num_threads = (opts->num_threads > 0) ? opts->num_threads : omp_get_max_threads();
+    struct Deque *deques = malloc(num_threads * sizeof(struct Deque));
+    double **sums = calloc(num_threads, sizeof(double *));
+    _Atomic long outstanding = n; // intervals that are queued or currently being processed
+
+    if (deques == NULL || sums == NULL) {
+        printf("Unable to allocate deques - exiting\n");
+        exit(1);
+    }
+
+    // All problems share one frontier, so threads that finish an easy
+    // problem carry on with the intervals of harder ones
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int id = omp_get_thread_num();
+        int team = omp_get_num_threads(); // may be fewer than requested
+        struct Deque *own = &deques[id];
+        int victim = id;
+        int delay = 1; // idle spin, see backoff()
+
+        // Each thread owns one row of per-problem partial sums
+        sums[id] = calloc(n > 0 ? n : 1, sizeof(double));
+        if (sums[id] == NULL) {
+            printf("Unable to allocate partial sums - exiting\n");
+            exit(1);
+        }
+        double *sum = sums[id];
+
+        // Seed the root intervals round-robin over the threads' own deques
+        deque_init(own);
+        for (int p = id; p < n; p += team) {
+            struct Interval whole;
+            double param = problems[p].param;
+            whole.left = problems[p].a;
+            whole.right = problems[p].b;
+            whole.tol = problems[p].tol;
+            whole.f_left = func(whole.left, param);
+            whole.f_right = func(whole.right, param);
+            whole.f_mid = func((whole.left + whole.right) / 2.0, param);
+            whole.share = 0.0;
+            whole.id = p;
+            deque_push(whole, own);
+        }
+        #pragma omp barrier
+
+        while (1) {
+            struct Interval interval;
+            int found = deque_pop(own, &interval);
+
+            // Own deque is empty, try the other threads in turn
+            for (int k = 1; !found && k < team; k++) {
+                victim = (victim + 1) % team;
+                if (victim != id) {
+                    found = deque_steal(&deques[victim], &interval);
+                }
+            }
+
+            if (!found) {
+                // No work anywhere we looked - finished only if nothing is outstanding,
+                // otherwise wait a while before looking again
+                if (atomic_load(&outstanding) == 0) {
+                    break;
+                }
+                backoff(&delay);
+                continue;
+            }
+            delay = 1;
+
+            double param = problems[interval.id].param;
+            double h = interval.right - interval.left;
+            double c = (interval.left + interval.right) / 2.0;
+            double d = (interval.left + c) / 2.0;
+            double e = (c + interval.right) / 2.0;
+            double fd = func(d, param);
+            double fe = func(e, param);
+
+            // Calculate integral estimates using 3 and 5 points respectively
+            double q1 = h / 6.0 * (interval.f_left + 4.0 * interval.f_mid + interval.f_right);
+            double q2 = h / 12.0 * (interval.f_left + 4.0 * fd + 2.0 * interval.f_mid + 4.0 * fe + interval.f_right);
+
+            if ((fabs(q2 - q1) < interval.tol) || ((interval.right - interval.left) < 1.0e-12)) {
+                // Tolerance is met, add to this thread's total for the problem
+                sum[interval.id] += q2 + (q2 - q1) / 15.0;
+                atomic_fetch_sub(&outstanding, 1);
+            } else {
+                // Tolerance is not met, split interval in two and push both halves on our own deque
+                struct Interval i1, i2;
+                split_interval(&interval, fd, fe, fabs(q2 - q1), &i1, &i2);
+
+                // one interval consumed, two added
+                atomic_fetch_add(&outstanding, 1);
+                deque_push(i2, own);
+                deque_push(i1, own);
+            }
+        }
+
+        // Thieves may still be reading from our deque until everyone is done
+        #pragma omp barrier
+        deque_destroy(own);
+
+        // Combine the partial sums in thread order, each thread taking a share of the problems
+        #pragma omp for schedule(static)
+        for (int p = 0; p < n; p++) {
+            double total = 0.0;
+            for (int t = 0; t < team; t++) {
+                total += sums[t][p];
+            }
+            results[p] = total;
+        }
+    }
+
+    for (int t = 0; t < num_threads; t++) {
+        free(sums[t]);
+    }
+    free(sums);
+    free(deques);
+}
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "level.h"
+#include "quadrature_mpi.h"
+
+#define IMBALANCE 1.25 // largest frontier allowed, relative to the average, before rebalancing
+
+// state used by exchange() between levels
+struct Exchange {
+    MPI_Comm comm;          // communicator shared by all ranks
+    int rank, size;         // this rank and number of ranks
+    long *counts;           // frontier size of every rank
+    int *send_counts, *send_displs, *recv_counts, *recv_displs; // Alltoallv arguments, in doubles
+    double *send, *recv;    // packed intervals, five doubles each
+    long buffer;            // allocated intervals in send and recv
+};
+
+// grow a packing buffer to hold n intervals
+static double *reserve_buffer(double *buf, long n) {
+    buf = realloc(buf, (n > 0 ? 5 * n : 1) * sizeof(double));
+    if (buf == NULL) {
+        printf("Unable to allocate exchange buffer - exiting\n");
+        exit(1);
+    }
+    return buf;
+}
+
+// Rebalance the frontier across the ranks and return its total size.
+// The intervals of all ranks, in rank order, are treated as one list and
+// rank r ends up with the r-th equal share of it, so each rank only sends
+// the overlap of what it holds with the other ranks' shares and the
+// frontier stays in left-to-right order.
+static long exchange(struct Level *level, void *arg) {
+    struct Exchange *ex = arg;
+    long total = 0, max = 0;
+
+    MPI_Allgather(&(level->count), 1, MPI_LONG, ex->counts, 1, MPI_LONG, ex->comm);
+    for (int r = 0; r < ex->size; r++) {
+        total += ex->counts[r];
+        if (ex->counts[r] > max) {
+            max = ex->counts[r];
+        }
+    }
+    if (total == 0 || max <= IMBALANCE * total / ex->size + 1) {
+        return total;
+    }
+
+    // Global positions held by this rank before and after rebalancing
+    long held = 0;
+    for (int r = 0; r < ex->rank; r++) {
+        held += ex->counts[r];
+    }
+    long share = total / ex->size, extra = total % ex->size;
+    long begin = held, end = held + level->count;
+    long target_begin = ex->rank * share + (ex->rank < extra ? ex->rank : extra);
+    long target_end = target_begin + share + (ex->rank < extra ? 1 : 0);
+
+    // Work out what goes to every rank, and what comes from every rank
+    long from = 0, sent = 0, received = 0;
+    for (int r = 0; r < ex->size; r++) {
+        long r_begin = r * share + (r < extra ? r : extra);
+        long r_end = r_begin + share + (r < extra ? 1 : 0);
+        long lo = (begin > r_begin) ? begin : r_begin, hi = (end < r_end) ? end : r_end;
+        long out = (hi > lo) ? hi - lo : 0;
+
+        lo = (from > target_begin) ? from : target_begin;
+        hi = (from + ex->counts[r] < target_end) ? from + ex->counts[r] : target_end;
+        long in = (hi > lo) ? hi - lo : 0;
+        from += ex->counts[r];
+
+        ex->send_counts[r] = 5 * out;
+        ex->send_displs[r] = 5 * sent;
+        ex->recv_counts[r] = 5 * in;
+        ex->recv_displs[r] = 5 * received;
+        sent += out;
+        received += in;
+    }
+
+    if (sent > ex->buffer || received > ex->buffer) {
+        ex->buffer = (sent > received) ? sent : received;
+        ex->send = reserve_buffer(ex->send, ex->buffer);
+        ex->recv = reserve_buffer(ex->recv, ex->buffer);
+    }
+    for (long i = 0; i < level->count; i++) {
+        ex->send[5 * i] = level->left[i];
+        ex->send[5 * i + 1] = level->right[i];
+        ex->send[5 * i + 2] = level->f_left[i];
+        ex->send[5 * i + 3] = level->f_mid[i];
+        ex->send[5 * i + 4] = level->f_right[i];
+    }
+
+    MPI_Alltoallv(ex->send, ex->send_counts, ex->send_displs, MPI_DOUBLE,
+                  ex->recv, ex->recv_counts, ex->recv_displs, MPI_DOUBLE, ex->comm);
+
+    reserve_level(level, received);
+    for (long i = 0; i < received; i++) {
+        level->left[i] = ex->recv[5 * i];
+        level->right[i] = ex->recv[5 * i + 1];
+        level->f_left[i] = ex->recv[5 * i + 2];
+        level->f_mid[i] = ex->recv[5 * i + 3];
+        level->f_right[i] = ex->recv[5 * i + 4];
+    }
+    level->count = received;
+    return total;
+}
+
+double integrate_mpi(double (*func)(double), double a, double b, double tol, const struct Options *opts, MPI_Comm comm) {
+    struct Options defaults;
+    struct Exchange ex;
+    struct Level start = {0};
+
+    if (opts == NULL) {
+        default_options(&defaults);
+        opts = &defaults;
+    }
+    int num_threads = (opts->num_threads > 0) ? opts->num_threads : omp_get_max_threads();
+
+    // Same limits as the breadth-first strategy that every rank runs
+    if (opts->rule != RULE_SIMPSON) {
+        printf("Rule %s is not supported by the MPI backend - exiting\n", rule_name(opts->rule));
+        exit(1);
+    }
+    if (opts->budget != NULL || opts->progress != NULL) {
+        printf("Budgets and progress are not supported by the MPI backend - exiting\n");
+        exit(1);
+    }
+    if (opts->stats != NULL || opts->trace != NULL) {
+        printf("Stats and traces are not supported by the MPI backend - exiting\n");
+        exit(1);
+    }
+    if (opts->cache != NULL || opts->checkpoint != NULL) {
+        // Ranks would all write the same file
+        printf("Caches and checkpoints are not supported by the MPI backend - exiting\n");
+        exit(1);
+    }
+
+    ex.comm = comm;
+    MPI_Comm_rank(comm, &(ex.rank));
+    MPI_Comm_size(comm, &(ex.size));
+    ex.counts = malloc(ex.size * sizeof(long));
+    ex.send_counts = malloc(4 * ex.size * sizeof(int));
+    if (ex.counts == NULL || ex.send_counts == NULL) {
+        printf("Unable to allocate exchange buffer - exiting\n");
+        exit(1);
+    }
+    ex.send_displs = ex.send_counts + ex.size;
+    ex.recv_counts = ex.send_counts + 2 * ex.size;
+    ex.recv_displs = ex.send_counts + 3 * ex.size;
+    ex.send = NULL;
+    ex.recv = NULL;
+    ex.buffer = 0;
+
+    // The whole domain starts on rank 0 and the first exchanges spread its
+    // children out, so the tree does not depend on the number of ranks
+    reserve_level(&start, 1);
+    if (ex.rank == 0) {
+        start.left[0] = a;
+        start.right[0] = b;
+        start.f_left[0] = func(a);
+        start.f_mid[0] = func((a + b) / 2.0);
+        start.f_right[0] = func(b);
+        start.count = 1;
+    }
+
+    double local = refine_levels(func, &start, 0.0, tol, opts, num_threads, exchange, &ex);
+    double quad;
+    // The ranks' partials cover different intervals for different rank counts,
+    // so the last bits of the sum can change with the number of ranks
+    MPI_Allreduce(&local, &quad, 1, MPI_DOUBLE, MPI_SUM, comm);
+
+    free(ex.counts);
+    free(ex.send_counts);
+    free(ex.send);
+    free(ex.recv);
+    return quad;
+}
@@ -0,0 +1,41 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <mpi.h>
+#include "function.h"
+#include "quadrature_mpi.h"
+
+// usage: mpirun -n <ranks> integrate-mpi [left right tol]
+int main(int argc, char **argv) {
+    struct Options opts;
+    double left = 0.0, right = 10.0, tol = 1e-06;
+    int provided, rank;
+
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    if (provided < MPI_THREAD_FUNNELED) {
+        printf("MPI does not support MPI_THREAD_FUNNELED - exiting\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    default_options(&opts);
+    opts.batch_func = func1_vec;
+    if (argc > 3) {
+        left = atof(argv[1]);
+        right = atof(argv[2]);
+        tol = atof(argv[3]);
+    }
+
+    double start = MPI_Wtime(); // Start the timer
+    double quad = integrate_mpi(func1, left, right, tol, &opts, MPI_COMM_WORLD);
+    double time = MPI_Wtime() - start; // Calculate the elapsed time
+
+    if (rank == 0) {
+        int size;
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+        printf("Ranks = %d\n", size);
+        printf("Result = %e\n", quad);
+        printf("Time(s) = %f\n", time);
+    }
+    MPI_Finalize();
+    return 0;
+}
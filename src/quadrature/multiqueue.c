@@ -0,0 +1,205 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <omp.h>
+#include "accumulator.h"
+#include "backoff.h"
+#include "probe.h"
+#include "rule.h"
+#include "solvers.h"
+
+#define QUEUESIZE 256 // initial capacity of each queue
+
+// Depth-first adaptive quadrature over a MultiQueue frontier: P locked
+// stacks (opts->queues_per_thread per thread) with no owner. Each child is
+// pushed to a random stack, moving on to another one whenever the lock is
+// busy, so no thread waits on a push. A pop looks at two random stacks and
+// takes from the fuller one ("power of two choices"), which keeps the
+// stacks evenly loaded without a shared counter.
+
+// stack of intervals, padded so that each one owns its cache lines
+struct MultiQueue {
+    _Alignas(64) omp_lock_t lock;     // protects entry
+    struct Interval *entry;           // pending intervals
+    int capacity;                     // allocated number of intervals
+    _Atomic int count;                // number of pending intervals; read without the lock
+};
+
+// xorshift random number generator, one state per thread
+static unsigned int next_random(unsigned int *state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// add an interval to a stack (caller holds the lock)
+static void stack_push(struct MultiQueue *queue, struct Interval interval) {
+    int count = atomic_load_explicit(&(queue->count), memory_order_relaxed);
+    if (count == queue->capacity) {
+        queue->capacity = (queue->capacity == 0) ? QUEUESIZE : 2 * queue->capacity;
+        queue->entry = realloc(queue->entry, queue->capacity * sizeof(struct Interval));
+        if (queue->entry == NULL) {
+            printf("Unable to allocate queue storage - exiting\n");
+            exit(1);
+        }
+    }
+    queue->entry[count] = interval;
+    atomic_store_explicit(&(queue->count), count + 1, memory_order_relaxed);
+}
+
+// push onto a random stack, moving on whenever a stack is busy
+static void push(struct MultiQueue *queues, int num_queues, unsigned int *seed, struct Interval interval,
+                 struct ThreadStats *st) {
+    double t = probe_start(st);
+    while (1) {
+        struct MultiQueue *queue = &queues[next_random(seed) % num_queues];
+        if (omp_test_lock(&(queue->lock))) {
+            probe_lock(st, t);
+            stack_push(queue, interval);
+            probe_depth(st, atomic_load_explicit(&(queue->count), memory_order_relaxed));
+            omp_unset_lock(&(queue->lock));
+            return;
+        }
+    }
+}
+
+// take the newest interval of a locked stack, returns 0 if it is empty
+static int take(struct MultiQueue *queue, struct Interval *interval) {
+    int count = atomic_load_explicit(&(queue->count), memory_order_relaxed);
+    if (count > 0) {
+        *interval = queue->entry[count - 1];
+        atomic_store_explicit(&(queue->count), count - 1, memory_order_relaxed);
+    }
+    omp_unset_lock(&(queue->lock));
+    return count > 0;
+}
+
+// pop from the fuller of two random stacks, falling back to a full scan
+// returns 0 if every stack was found empty
+static int pop(struct MultiQueue *queues, int num_queues, unsigned int *seed, struct Interval *interval,
+               struct ThreadStats *st) {
+    for (int attempt = 0; attempt < num_queues; attempt++) {
+        struct MultiQueue *a = &queues[next_random(seed) % num_queues];
+        struct MultiQueue *b = &queues[next_random(seed) % num_queues];
+        struct MultiQueue *queue = (atomic_load(&(a->count)) >= atomic_load(&(b->count))) ? a : b;
+        if (atomic_load(&(queue->count)) == 0 || !omp_test_lock(&(queue->lock))) {
+            continue;
+        }
+        if (take(queue, interval)) {
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < num_queues; i++) {
+        struct MultiQueue *queue = &queues[i];
+        if (atomic_load(&(queue->count)) == 0) {
+            continue;
+        }
+        double t = probe_start(st);
+        omp_set_lock(&(queue->lock));
+        probe_lock(st, t);
+        if (take(queue, interval)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+double integrate_multi_queue(double (*func)(double), struct Interval whole, const struct Options *opts, int num_threads) {
+    int num_queues = ((opts->queues_per_thread > 0) ? opts->queues_per_thread : 1) * num_threads;
+    struct MultiQueue *queues = aligned_alloc(64, num_queues * sizeof(struct MultiQueue));
+    struct Accumulator *acc = new_accumulators(num_threads);
+    const struct GKRule *gk = gk_rule(opts->rule);
+    _Atomic long outstanding = 1; // intervals that are queued or currently being processed
+
+    if (queues == NULL) {
+        printf("Unable to allocate queue storage - exiting\n");
+        exit(1);
+    }
+    for (int i = 0; i < num_queues; i++) {
+        omp_init_lock(&(queues[i].lock));
+        queues[i].entry = NULL;
+        queues[i].capacity = 0;
+        atomic_init(&(queues[i].count), 0);
+    }
+    stack_push(&queues[0], whole);
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int id = omp_get_thread_num();
+        struct Accumulator *sum = &acc[id];
+        unsigned int seed = 2654435761u * (id + 1);
+        int delay = 1; // idle spin, see backoff()
+        struct ThreadStats *st = thread_stats(opts->stats, id);
+
+        cache_enter(opts->cache);
+
+        while (1) {
+            struct Interval interval;
+            double t = probe_start(st);
+            if (!pop(queues, num_queues, &seed, &interval, st)) {
+                // No work anywhere we looked - finished only if nothing is outstanding,
+                // otherwise wait a while before looking again
+                if (atomic_load(&outstanding) == 0) {
+                    probe_idle(st, t);
+                    break;
+                }
+                backoff(&delay);
+                probe_idle(st, t);
+                continue;
+            }
+            delay = 1;
+
+            double h = interval.right - interval.left;
+            double c = (interval.left + interval.right) / 2.0;
+            double d = (interval.left + c) / 2.0;
+            double e = (c + interval.right) / 2.0;
+            double fd = 0.0, fe = 0.0, quad, err;
+            t = probe_start(st);
+            if (gk == NULL) {
+                // Calculate integral estimates using 3 and 5 points respectively
+                fd = func(d);
+                fe = func(e);
+                probe_eval(st, 2, t);
+                double q1 = h / 6.0 * (interval.f_left + 4.0 * interval.f_mid + interval.f_right);
+                double q2 = h / 12.0 * (interval.f_left + 4.0 * fd + 2.0 * interval.f_mid + 4.0 * fe + interval.f_right);
+                err = fabs(q2 - q1);
+                quad = q2 + (q2 - q1) / 15.0;
+            } else {
+                // Kronrod estimate, none of whose nodes are reused by the subintervals
+                quad = gk_apply(gk, func, interval.left, interval.right, &err);
+                probe_eval(st, 2 * gk->n + 1, t);
+            }
+            probe_intervals(st, 1);
+            budget_charge(opts->budget, (gk == NULL) ? 2 : 2 * gk->n + 1);
+
+            if ((err < interval.tol) || (h < 1.0e-12) || budget_stop(opts->budget, h, err)) {
+                // Tolerance is met or the budget is spent, add to this thread's total
+                accumulate(sum, interval.left, quad);
+                progress_leaf(opts->progress, id, h, quad, interval.share);
+                atomic_fetch_sub(&outstanding, 1);
+            } else {
+                // Tolerance is not met, split interval in two and push each half to a random stack
+                struct Interval i1, i2;
+                split_interval(&interval, fd, fe, err, &i1, &i2);
+                progress_split(opts->progress, id, interval.share, err);
+
+                // one interval consumed, two added
+                atomic_fetch_add(&outstanding, 1);
+                push(queues, num_queues, &seed, i2, st);
+                push(queues, num_queues, &seed, i1, st);
+            }
+        }
+    }
+
+    for (int i = 0; i < num_queues; i++) {
+        omp_destroy_lock(&(queues[i].lock));
+        free(queues[i].entry);
+    }
+    free(queues);
+    return reduce(acc, num_threads);
+}
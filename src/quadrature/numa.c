@@ -0,0 +1,83 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <sched.h>
+#include <omp.h>
+#include "numa.h"
+
+#define MAXRANGES 1024
+
+// Read a sysfs list such as "0-3,8,10-11" into ranges first[i] to last[i].
+// Returns the number of ranges, 0 if the file cannot be read.
+static int read_list(const char *path, int *first, int *last) {
+    FILE *file = fopen(path, "r");
+    int n = 0;
+
+    if (file == NULL) {
+        return 0;
+    }
+    while (n < MAXRANGES && fscanf(file, "%d", &first[n]) == 1) {
+        int c = fgetc(file);
+        last[n] = first[n];
+        if (c == '-') {
+            if (fscanf(file, "%d", &last[n]) != 1) {
+                break;
+            }
+            c = fgetc(file);
+        }
+        n++;
+        if (c != ',') {
+            break;
+        }
+    }
+    fclose(file);
+    return n;
+}
+
+int numa_domains(void) {
+    int first[MAXRANGES], last[MAXRANGES];
+    int n = read_list("/sys/devices/system/node/online", first, last);
+    int count = 0;
+
+    for (int i = 0; i < n; i++) {
+        count += last[i] - first[i] + 1;
+    }
+    return (count > 0) ? count : 1;
+}
+
+int numa_domain(int domains) {
+    int nodes_first[MAXRANGES], nodes_last[MAXRANGES];
+    int cpus_first[MAXRANGES], cpus_last[MAXRANGES];
+    int cpu = sched_getcpu();
+    int n = (cpu >= 0) ? read_list("/sys/devices/system/node/online", nodes_first, nodes_last) : 0;
+    int domain = 0;
+
+    // The domain is the position among the online nodes of the node whose
+    // cpulist holds our CPU, so it does not matter how CPUs are numbered
+    for (int i = 0; i < n; i++) {
+        for (int node = nodes_first[i]; node <= nodes_last[i]; node++, domain++) {
+            char path[64];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+            int m = read_list(path, cpus_first, cpus_last);
+            for (int j = 0; j < m; j++) {
+                if (cpu >= cpus_first[j] && cpu <= cpus_last[j]) {
+                    return domain % domains;
+                }
+            }
+        }
+    }
+    // No topology to go by, so group consecutive threads
+    return omp_get_thread_num() * domains / omp_get_num_threads();
+}
+
+void numa_victims(int id, int num_threads, const int *domain, int *order) {
+    int n = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (int k = 1; k < num_threads; k++) {
+            int victim = (id + k) % num_threads;
+            if ((domain[victim] == domain[id]) == (pass == 0)) {
+                order[n++] = victim;
+            }
+        }
+    }
+}
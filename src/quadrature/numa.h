@@ -0,0 +1,22 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+// Placement helpers for Options.numa. Strategies bind their threads with
+// proc_bind(close) so that with OMP_PLACES=cores (or sockets) they stay on
+// one CPU, and each thread finds its domain from the node that CPU belongs
+// to. Shared structures are then first touched by a thread in the domain
+// that uses them, however the machine numbers its CPUs.
+
+// number of NUMA domains on this machine, 1 if it cannot be read
+int numa_domains(void);
+
+// domain of the calling thread, 0 to domains - 1, from the node of the CPU it
+// runs on, or from its thread number if the topology cannot be read
+int numa_domain(int domains);
+
+// order in which thread id of a team of num_threads tries its victims:
+// the other threads of its own domain, then the rest, each starting after id
+// order receives num_threads - 1 entries
+void numa_victims(int id, int num_threads, const int *domain, int *order);
+
+#endif
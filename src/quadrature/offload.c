@@ -0,0 +1,241 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "function.h"
+#include "quadrature_offload.h"
+
+#define BLOCK 64 // intervals handled by one device thread per level
+
+// Breadth-first refinement with the whole frontier kept in device memory.
+// Each level is two kernels: the first evaluates the quarter points, applies
+// the convergence test and counts the splits in every block of BLOCK
+// intervals; the second writes the children of each block into the next
+// level, starting at the block's offset. Only the per-block split counts,
+// their prefix sum and one partial sum per level cross the host link; the
+// intervals themselves never leave the device.
+
+// one level of the frontier in device memory, structure-of-arrays
+struct DeviceLevel {
+    long count;             // number of intervals
+    long capacity;          // allocated number of intervals
+    double *left;           // left boundaries
+    double *right;          // right boundaries
+    double *f_left;         // function values at left boundaries
+    double *f_mid;          // function values at midpoints
+    double *f_right;        // function values at right boundaries
+};
+
+// device scratch space for one level
+struct DeviceWork {
+    long capacity;          // allocated number of intervals
+    double *f_d, *f_e;      // function values at one-quarter and three-quarter points
+    char *split;            // whether each interval is split
+    long *offset;           // split count, then first child, of each block
+};
+
+// allocate device memory, exiting if it cannot be had
+static void *device_alloc(size_t size, int device) {
+    void *p = omp_target_alloc(size > 0 ? size : 1, device);
+    if (p == NULL) {
+        printf("Unable to allocate device memory - exiting\n");
+        exit(1);
+    }
+    return p;
+}
+
+// make room for at least n intervals in a device level, discarding its contents
+static void reserve_device_level(struct DeviceLevel *level, long n, int device) {
+    if (n <= level->capacity) {
+        return;
+    }
+    long capacity = (level->capacity == 0) ? 1024 : level->capacity;
+    while (capacity < n) {
+        capacity *= 2;
+    }
+    omp_target_free(level->left, device);
+    level->left = device_alloc(5 * capacity * sizeof(double), device);
+    level->right = level->left + capacity;
+    level->f_left = level->right + capacity;
+    level->f_mid = level->f_left + capacity;
+    level->f_right = level->f_mid + capacity;
+    level->capacity = capacity;
+}
+
+// make room for at least n intervals in the device scratch space
+static void reserve_device_work(struct DeviceWork *work, long n, int device) {
+    if (n <= work->capacity) {
+        return;
+    }
+    long capacity = (work->capacity == 0) ? 1024 : work->capacity;
+    while (capacity < n) {
+        capacity *= 2;
+    }
+    omp_target_free(work->f_d, device);
+    omp_target_free(work->split, device);
+    omp_target_free(work->offset, device);
+    work->f_d = device_alloc(2 * capacity * sizeof(double), device);
+    work->f_e = work->f_d + capacity;
+    work->split = device_alloc(capacity, device);
+    work->offset = device_alloc((capacity / BLOCK + 1) * sizeof(long), device);
+    work->capacity = capacity;
+}
+
+// refine [a, b] level by level on device and return the integral
+static double refine_on_device(double a, double b, double tol, int device) {
+    struct DeviceLevel levels[2] = {{0}, {0}};
+    struct DeviceLevel *cur = &levels[0], *next = &levels[1];
+    struct DeviceWork work = {0};
+    long *offset = NULL; // host copy of the per-block counts
+    long blocks_allocated = 0;
+    int host = omp_get_initial_device();
+    double quad = 0.0;
+
+    // Set up the initial interval on the host and copy it over
+    double whole[5] = {a, b, func1(a), func1((a + b) / 2.0), func1(b)};
+    reserve_device_level(cur, 1, device);
+    double *field[5] = {cur->left, cur->right, cur->f_left, cur->f_mid, cur->f_right};
+    for (int k = 0; k < 5; k++) {
+        omp_target_memcpy(field[k], &whole[k], sizeof(double), 0, 0, device, host);
+    }
+    cur->count = 1;
+
+    while (cur->count > 0) {
+        long n = cur->count;
+        long blocks = (n + BLOCK - 1) / BLOCK;
+        double level_sum = 0.0;
+
+        reserve_device_work(&work, n, device);
+        if (blocks + 1 > blocks_allocated) {
+            blocks_allocated = 2 * (blocks + 1);
+            offset = realloc(offset, blocks_allocated * sizeof(long));
+            if (offset == NULL) {
+                printf("Unable to allocate queue storage - exiting\n");
+                exit(1);
+            }
+        }
+
+        double *left = cur->left, *right = cur->right;
+        double *f_left = cur->f_left, *f_mid = cur->f_mid, *f_right = cur->f_right;
+        double *f_d = work.f_d, *f_e = work.f_e;
+        char *split = work.split;
+        long *count = work.offset;
+
+        // Evaluate the quarter points and test every interval for convergence
+        #pragma omp target teams distribute parallel for device(device) map(tofrom: level_sum) \
+                reduction(+:level_sum) is_device_ptr(left, right, f_left, f_mid, f_right, f_d, f_e, split, count)
+        for (long k = 0; k < blocks; k++) {
+            long lo = k * BLOCK, hi = (lo + BLOCK < n) ? lo + BLOCK : n;
+            long splits = 0;
+            for (long i = lo; i < hi; i++) {
+                double h = right[i] - left[i];
+                double c = (left[i] + right[i]) / 2.0;
+                f_d[i] = func1((left[i] + c) / 2.0);
+                f_e[i] = func1((c + right[i]) / 2.0);
+
+                // Calculate integral estimates using 3 and 5 points respectively
+                double q1 = h / 6.0 * (f_left[i] + 4.0 * f_mid[i] + f_right[i]);
+                double q2 = h / 12.0 * (f_left[i] + 4.0 * f_d[i] + 2.0 * f_mid[i] + 4.0 * f_e[i] + f_right[i]);
+
+                if ((fabs(q2 - q1) < tol) || (h < 1.0e-12)) {
+                    // Tolerance is met, add to this level's total
+                    level_sum += q2 + (q2 - q1) / 15.0;
+                    split[i] = 0;
+                } else {
+                    split[i] = 1;
+                    splits++;
+                }
+            }
+            count[k] = splits;
+        }
+        quad += level_sum;
+
+        // Prefix sum over the block counts gives each block its first slot in the next level
+        omp_target_memcpy(offset, count, blocks * sizeof(long), 0, 0, host, device);
+        long total = 0;
+        for (long k = 0; k < blocks; k++) {
+            long splits = offset[k];
+            offset[k] = 2 * total;
+            total += splits;
+        }
+        if (total == 0) {
+            break;
+        }
+        omp_target_memcpy(count, offset, blocks * sizeof(long), 0, 0, device, host);
+        reserve_device_level(next, 2 * total, device);
+        next->count = 2 * total;
+
+        double *n_left = next->left, *n_right = next->right;
+        double *n_f_left = next->f_left, *n_f_mid = next->f_mid, *n_f_right = next->f_right;
+
+        // Tolerance is not met, split interval in two and write both halves to the next level
+        #pragma omp target teams distribute parallel for device(device) \
+                is_device_ptr(left, right, f_left, f_mid, f_right, f_d, f_e, split, count, \
+                              n_left, n_right, n_f_left, n_f_mid, n_f_right)
+        for (long k = 0; k < blocks; k++) {
+            long lo = k * BLOCK, hi = (lo + BLOCK < n) ? lo + BLOCK : n;
+            long j = count[k];
+            for (long i = lo; i < hi; i++) {
+                if (split[i]) {
+                    double c = (left[i] + right[i]) / 2.0;
+
+                    n_left[j] = left[i];
+                    n_right[j] = c;
+                    n_f_left[j] = f_left[i];
+                    n_f_mid[j] = f_d[i];
+                    n_f_right[j] = f_mid[i];
+
+                    n_left[j + 1] = c;
+                    n_right[j + 1] = right[i];
+                    n_f_left[j + 1] = f_mid[i];
+                    n_f_mid[j + 1] = f_e[i];
+                    n_f_right[j + 1] = f_right[i];
+                    j += 2;
+                }
+            }
+        }
+
+        struct DeviceLevel *swap = cur;
+        cur = next;
+        next = swap;
+    }
+
+    omp_target_free(levels[0].left, device);
+    omp_target_free(levels[1].left, device);
+    omp_target_free(work.f_d, device);
+    omp_target_free(work.split, device);
+    omp_target_free(work.offset, device);
+    free(offset);
+    return quad;
+}
+
+double integrate_offload(double a, double b, double tol, int device, const struct Options *opts) {
+    if (device < 0) {
+        if (omp_get_num_devices() == 0) {
+            // No accelerator, use the CPU solvers instead
+            return integrate(func1, a, b, tol, opts);
+        }
+        device = omp_get_default_device();
+    }
+
+    // The device kernels are the breadth-first refinement with Simpson's rule and no probes
+    if (opts != NULL) {
+        if (opts->rule != RULE_SIMPSON) {
+            printf("Rule %s is not supported by the offload device - exiting\n", rule_name(opts->rule));
+            exit(1);
+        }
+        if (opts->budget != NULL || opts->progress != NULL) {
+            printf("Budgets and progress are not supported by the offload device - exiting\n");
+            exit(1);
+        }
+        if (opts->stats != NULL || opts->trace != NULL) {
+            printf("Stats and traces are not supported by the offload device - exiting\n");
+            exit(1);
+        }
+        if (opts->cache != NULL || opts->checkpoint != NULL) {
+            printf("Caches and checkpoints are not supported by the offload device - exiting\n");
+            exit(1);
+        }
+    }
+    return refine_on_device(a, b, tol, device);
+}
@@ -0,0 +1,34 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "function.h"
+#include "quadrature_offload.h"
+
+// usage: integrate-offload [left right tol [device]]
+int main(int argc, char **argv) {
+    struct Options opts;
+    double left = 0.0, right = 10.0, tol = 1e-06;
+    int device = -1;
+
+    // CPU fallback when no device is present
+    default_options(&opts);
+    opts.strategy = STRATEGY_BREADTH_FIRST;
+    opts.batch_func = func1_vec;
+    if (argc > 3) {
+        left = atof(argv[1]);
+        right = atof(argv[2]);
+        tol = atof(argv[3]);
+    }
+    if (argc > 4) {
+        device = atoi(argv[4]);
+    }
+
+    double start = omp_get_wtime(); // Start the timer
+    double quad = integrate_offload(left, right, tol, device, &opts);
+    double time = omp_get_wtime() - start; // Calculate the elapsed time
+
+    printf("Devices = %d\n", omp_get_num_devices());
+    printf("Result = %e\n", quad);
+    printf("Time(s) = %f\n", time);
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <omp.h>
+#include "pool.h"
+#include "solvers.h"
+
+#define SPIN 2000 // polls of the queue before an idle worker goes to sleep
+
+struct Job {
+    double (*func)(double);  // integrand
+    double a, b, tol;        // domain and tolerance
+    double result;           // integral, valid once done is set
+    int done;                // set by the worker when finished
+    struct Pool *pool;       // pool the job was submitted to
+    struct Job *next;        // next job in the submission queue
+};
+
+struct Pool {
+    pthread_t *workers;      // worker threads
+    int num_workers;         // number of worker threads
+    struct Job *head;        // oldest queued job
+    struct Job *tail;        // newest queued job
+    _Atomic int queued;      // number of queued jobs, polled without the lock
+    int sleeping;            // workers blocked on work
+    int shutdown;            // set by pool_destroy
+    pthread_mutex_t lock;    // protects the queue and job completion
+    pthread_cond_t work;     // signalled when a job is queued
+    pthread_cond_t finished; // broadcast when a job completes
+};
+
+static void *worker(void *arg) {
+    struct Pool *pool = arg;
+
+    while (1) {
+        // Poll briefly before sleeping so back-to-back jobs skip the wake-up cost
+        for (int i = 0; i < SPIN && atomic_load(&(pool->queued)) == 0; i++) {
+        }
+
+        pthread_mutex_lock(&(pool->lock));
+        while (pool->head == NULL && !pool->shutdown) {
+            pool->sleeping++;
+            pthread_cond_wait(&(pool->work), &(pool->lock));
+            pool->sleeping--;
+        }
+        if (pool->head == NULL) {
+            // shutting down and nothing left to do
+            pthread_mutex_unlock(&(pool->lock));
+            break;
+        }
+        struct Job *job = pool->head;
+        pool->head = job->next;
+        if (pool->head == NULL) {
+            pool->tail = NULL;
+        }
+        atomic_fetch_sub(&(pool->queued), 1);
+        pthread_mutex_unlock(&(pool->lock));
+
+        struct Interval whole;
+        whole.left = job->a;
+        whole.right = job->b;
+        whole.tol = job->tol;
+        whole.f_left = job->func(whole.left);
+        whole.f_right = job->func(whole.right);
+        whole.f_mid = job->func((whole.left + whole.right) / 2.0);
+        whole.share = 0.0;
+        whole.id = 0;
+        double result = integrate_serial(job->func, whole, NULL);
+
+        pthread_mutex_lock(&(pool->lock));
+        job->result = result;
+        job->done = 1;
+        pthread_cond_broadcast(&(pool->finished));
+        pthread_mutex_unlock(&(pool->lock));
+    }
+
+    return NULL;
+}
+
+struct Pool *pool_create(int num_workers) {
+    struct Pool *pool = malloc(sizeof(struct Pool));
+    if (num_workers <= 0) {
+        num_workers = omp_get_max_threads();
+    }
+    if (pool != NULL) {
+        pool->workers = malloc(num_workers * sizeof(pthread_t));
+    }
+    if (pool == NULL || pool->workers == NULL) {
+        printf("Unable to allocate thread pool - exiting\n");
+        exit(1);
+    }
+
+    pool->num_workers = num_workers;
+    pool->head = NULL;
+    pool->tail = NULL;
+    atomic_init(&(pool->queued), 0);
+    pool->sleeping = 0;
+    pool->shutdown = 0;
+    pthread_mutex_init(&(pool->lock), NULL);
+    pthread_cond_init(&(pool->work), NULL);
+    pthread_cond_init(&(pool->finished), NULL);
+
+    for (int i = 0; i < num_workers; i++) {
+        if (pthread_create(&(pool->workers[i]), NULL, worker, pool) != 0) {
+            printf("Unable to start worker thread - exiting\n");
+            exit(1);
+        }
+    }
+    return pool;
+}
+
+struct Job *pool_submit(struct Pool *pool, double (*func)(double), double a, double b, double tol) {
+    struct Job *job = malloc(sizeof(struct Job));
+    if (job == NULL) {
+        printf("Unable to allocate job - exiting\n");
+        exit(1);
+    }
+    job->func = func;
+    job->a = a;
+    job->b = b;
+    job->tol = tol;
+    job->done = 0;
+    job->pool = pool;
+    job->next = NULL;
+
+    pthread_mutex_lock(&(pool->lock));
+    if (pool->tail != NULL) {
+        pool->tail->next = job;
+    } else {
+        pool->head = job;
+    }
+    pool->tail = job;
+    atomic_fetch_add(&(pool->queued), 1);
+    if (pool->sleeping > 0) {
+        pthread_cond_signal(&(pool->work));
+    }
+    pthread_mutex_unlock(&(pool->lock));
+    return job;
+}
+
+double job_wait(struct Job *job) {
+    struct Pool *pool = job->pool;
+
+    pthread_mutex_lock(&(pool->lock));
+    while (!job->done) {
+        pthread_cond_wait(&(pool->finished), &(pool->lock));
+    }
+    pthread_mutex_unlock(&(pool->lock));
+
+    double result = job->result;
+    free(job);
+    return result;
+}
+
+void pool_destroy(struct Pool *pool) {
+    pthread_mutex_lock(&(pool->lock));
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&(pool->work));
+    pthread_mutex_unlock(&(pool->lock));
+
+    for (int i = 0; i < pool->num_workers; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+
+    pthread_mutex_destroy(&(pool->lock));
+    pthread_cond_destroy(&(pool->work));
+    pthread_cond_destroy(&(pool->finished));
+    free(pool->workers);
+    free(pool);
+}
@@ -0,0 +1,25 @@
+#ifndef POOL_H
+#define POOL_H
+
+// Persistent pool of worker threads for streams of small integrals.
+// The workers are started once and then take jobs from a shared submission
+// queue, so each integral costs a queue operation rather than a parallel
+// region. Every job is integrated by a single worker with the serial
+// strategy, and independent jobs run concurrently on different workers.
+
+struct Pool;
+struct Job;
+
+// start a pool with the given number of workers, 0 for omp_get_max_threads()
+struct Pool *pool_create(int num_workers);
+
+// queue the integral of func over [a, b] to tolerance tol
+struct Job *pool_submit(struct Pool *pool, double (*func)(double), double a, double b, double tol);
+
+// wait for a job to finish, release it and return its result
+double job_wait(struct Job *job);
+
+// finish all queued jobs and stop the workers
+void pool_destroy(struct Pool *pool);
+
+#endif
@@ -0,0 +1,273 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <omp.h>
+#include "accumulator.h"
+#include "backoff.h"
+#include "probe.h"
+#include "solvers.h"
+
+#define HEAPS_PER_THREAD 2 // heaps in the relaxed priority queue per thread
+#define HEAPSIZE 256       // initial capacity of each heap
+
+// Global adaptive quadrature: rather than refining every interval until it
+// meets tol on its own, always refine the intervals with the largest error
+// estimate until the sum of all estimates falls below tol. The frontier is a
+// relaxed concurrent priority queue (a MultiQueue): several binary heaps,
+// each with its own lock, where pushes go to a random heap and pops take the
+// better top of two randomly chosen heaps.
+
+// interval with its quarter points already evaluated
+struct Segment {
+    double left, right;               // boundaries
+    double f_left, f_mid, f_right;    // function values at left, middle and right
+    double f_d, f_e;                  // function values at one-quarter and three-quarter points
+    double quad;                      // integral estimate
+    double err;                       // error estimate |q2 - q1|, the priority key
+};
+
+// max-heap on err, padded so that each heap owns its cache lines
+struct Heap {
+    _Alignas(64) omp_lock_t lock;     // protects entry and count
+    struct Segment *entry;            // binary heap of segments
+    int count;                        // number of segments in the heap
+    int capacity;                     // allocated number of segments
+    _Atomic double top;               // err of the root, or -1 when empty; read without the lock
+};
+
+// evaluate the quarter points of [left, right] and fill in the estimates
+static struct Segment evaluate(double (*func)(double), double left, double right,
+                               double f_left, double f_mid, double f_right, struct ThreadStats *st) {
+    struct Segment s;
+    double t = probe_start(st);
+    double h = right - left;
+    double c = (left + right) / 2.0;
+    s.left = left;
+    s.right = right;
+    s.f_left = f_left;
+    s.f_mid = f_mid;
+    s.f_right = f_right;
+    s.f_d = func((left + c) / 2.0);
+    s.f_e = func((c + right) / 2.0);
+    probe_eval(st, 2, t);
+    probe_intervals(st, 1);
+
+    // Calculate integral estimates using 3 and 5 points respectively
+    double q1 = h / 6.0 * (f_left + 4.0 * f_mid + f_right);
+    double q2 = h / 12.0 * (f_left + 4.0 * s.f_d + 2.0 * f_mid + 4.0 * s.f_e + f_right);
+    s.quad = q2 + (q2 - q1) / 15.0;
+    s.err = fabs(q2 - q1);
+    return s;
+}
+
+// xorshift random number generator, one state per thread
+static unsigned int next_random(unsigned int *state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// add a segment to a heap (caller holds the lock)
+static void heap_push(struct Heap *heap, struct Segment s) {
+    if (heap->count == heap->capacity) {
+        heap->capacity = (heap->capacity == 0) ? HEAPSIZE : 2 * heap->capacity;
+        heap->entry = realloc(heap->entry, heap->capacity * sizeof(struct Segment));
+        if (heap->entry == NULL) {
+            printf("Unable to allocate queue storage - exiting\n");
+            exit(1);
+        }
+    }
+    int i = heap->count++;
+    while (i > 0 && heap->entry[(i - 1) / 2].err < s.err) {
+        heap->entry[i] = heap->entry[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap->entry[i] = s;
+    atomic_store(&(heap->top), heap->entry[0].err);
+}
+
+// remove the segment with the largest error from a non-empty heap (caller holds the lock)
+static struct Segment heap_pop(struct Heap *heap) {
+    struct Segment worst = heap->entry[0];
+    struct Segment last = heap->entry[--heap->count];
+    int i = 0;
+    while (2 * i + 1 < heap->count) {
+        int child = 2 * i + 1;
+        if (child + 1 < heap->count && heap->entry[child + 1].err > heap->entry[child].err) {
+            child++;
+        }
+        if (heap->entry[child].err <= last.err) {
+            break;
+        }
+        heap->entry[i] = heap->entry[child];
+        i = child;
+    }
+    if (heap->count > 0) {
+        heap->entry[i] = last;
+    }
+    atomic_store(&(heap->top), (heap->count > 0) ? heap->entry[0].err : -1.0);
+    return worst;
+}
+
+// push onto a random heap, moving on whenever a heap is busy
+static void push(struct Heap *heaps, int num_heaps, unsigned int *seed, struct Segment s, struct ThreadStats *st) {
+    double t = probe_start(st);
+    while (1) {
+        struct Heap *heap = &heaps[next_random(seed) % num_heaps];
+        if (omp_test_lock(&(heap->lock))) {
+            probe_lock(st, t);
+            heap_push(heap, s);
+            probe_depth(st, heap->count);
+            omp_unset_lock(&(heap->lock));
+            return;
+        }
+    }
+}
+
+// pop from the better of two random heaps, falling back to a full scan
+// returns 0 if every heap was found empty
+static int pop(struct Heap *heaps, int num_heaps, unsigned int *seed, struct Segment *s, struct ThreadStats *st) {
+    for (int attempt = 0; attempt < num_heaps; attempt++) {
+        struct Heap *a = &heaps[next_random(seed) % num_heaps];
+        struct Heap *b = &heaps[next_random(seed) % num_heaps];
+        struct Heap *heap = (atomic_load(&(a->top)) >= atomic_load(&(b->top))) ? a : b;
+        if (atomic_load(&(heap->top)) < 0.0 || !omp_test_lock(&(heap->lock))) {
+            continue;
+        }
+        int found = (heap->count > 0);
+        if (found) {
+            *s = heap_pop(heap);
+        }
+        omp_unset_lock(&(heap->lock));
+        if (found) {
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < num_heaps; i++) {
+        struct Heap *heap = &heaps[i];
+        if (atomic_load(&(heap->top)) < 0.0) {
+            continue;
+        }
+        double t = probe_start(st);
+        omp_set_lock(&(heap->lock));
+        probe_lock(st, t);
+        int found = (heap->count > 0);
+        if (found) {
+            *s = heap_pop(heap);
+        }
+        omp_unset_lock(&(heap->lock));
+        if (found) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+double integrate_priority(double (*func)(double), struct Interval whole, const struct Options *opts, int num_threads) {
+    int num_heaps = HEAPS_PER_THREAD * num_threads;
+    struct Heap *heaps = aligned_alloc(64, num_heaps * sizeof(struct Heap));
+    struct Accumulator *acc = new_accumulators(num_threads);
+    double tol = whole.tol;
+
+    if (heaps == NULL) {
+        printf("Unable to allocate queue storage - exiting\n");
+        exit(1);
+    }
+    for (int i = 0; i < num_heaps; i++) {
+        omp_init_lock(&(heaps[i].lock));
+        heaps[i].entry = NULL;
+        heaps[i].count = 0;
+        heaps[i].capacity = 0;
+        atomic_init(&(heaps[i].top), -1.0);
+    }
+
+    struct Segment root = evaluate(func, whole.left, whole.right, whole.f_left, whole.f_mid, whole.f_right,
+                                   thread_stats(opts->stats, 0));
+    double total_err = root.err;  // sum of the error estimates of all segments
+    budget_charge(opts->budget, 2);
+    _Atomic long outstanding = 1; // segments that are queued or currently being refined
+    heap_push(&heaps[0], root);
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int id = omp_get_thread_num();
+        int team = omp_get_num_threads(); // may be fewer than requested
+        struct Accumulator *sum = &acc[id];
+        unsigned int seed = 2654435761u * (id + 1);
+        int delay = 1; // idle spin, see backoff()
+        struct ThreadStats *st = thread_stats(opts->stats, id);
+
+        cache_enter(opts->cache);
+
+        while (1) {
+            double err;
+            #pragma omp atomic read
+            err = total_err;
+            if (err <= tol || budget_spent(opts->budget)) {
+                // Estimated error over the whole domain is small enough, or no more work is allowed
+                break;
+            }
+
+            struct Segment s;
+            double t = probe_start(st);
+            if (!pop(heaps, num_heaps, &seed, &s, st)) {
+                // Nothing to refine, finished only if no other thread may push more,
+                // otherwise wait a while before looking again
+                if (atomic_load(&outstanding) == 0) {
+                    probe_idle(st, t);
+                    break;
+                }
+                backoff(&delay);
+                probe_idle(st, t);
+                continue;
+            }
+            delay = 1;
+
+            // Split the worst segment, reusing its quarter points as the children's midpoints
+            double c = (s.left + s.right) / 2.0;
+            struct Segment s1 = evaluate(func, s.left, c, s.f_left, s.f_d, s.f_mid, st);
+            struct Segment s2 = evaluate(func, c, s.right, s.f_mid, s.f_e, s.f_right, st);
+            budget_charge(opts->budget, 4);
+
+            #pragma omp atomic
+            total_err += s1.err + s2.err - s.err;
+
+            struct Segment child[2] = {s1, s2};
+            for (int k = 0; k < 2; k++) {
+                double width = child[k].right - child[k].left;
+                if (width < 1.0e-12 || budget_floor(opts->budget, width)) {
+                    // Too small to split again, its estimate is final
+                    accumulate(sum, child[k].left, child[k].quad);
+                } else {
+                    atomic_fetch_add(&outstanding, 1);
+                    push(heaps, num_heaps, &seed, child[k], st);
+                }
+            }
+            atomic_fetch_sub(&outstanding, 1);
+        }
+
+        // Every push has completed once all threads reach the barrier;
+        // the segments left in the heaps make up the rest of the result
+        #pragma omp barrier
+        for (int i = id; i < num_heaps; i += team) {
+            for (int j = 0; j < heaps[i].count; j++) {
+                accumulate(sum, heaps[i].entry[j].left, heaps[i].entry[j].quad);
+            }
+        }
+    }
+
+    if (opts->budget != NULL) {
+        opts->budget->error = total_err;
+    }
+    for (int i = 0; i < num_heaps; i++) {
+        omp_destroy_lock(&(heaps[i].lock));
+        free(heaps[i].entry);
+    }
+    free(heaps);
+    return reduce(acc, num_threads);
+}
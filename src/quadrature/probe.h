@@ -0,0 +1,260 @@
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <stdatomic.h>
+#include <omp.h>
+#include "quadrature.h"
+#include "progress.h"
+#include "stats.h"
+#include "trace.h"
+
+// Probes used by the strategies to fill in Options.stats, Options.trace and
+// Options.progress, and to enforce Options.budget. Each takes the calling
+// thread's counters or trace buffer, the progress or the budget, which are
+// NULL when they are off.
+
+// clear stats for a run on num_threads threads
+void stats_begin(struct Stats *stats, int num_threads);
+
+// counters of thread id, or NULL when stats are off
+static inline struct ThreadStats *thread_stats(const struct Stats *stats, int id) {
+    return (stats != NULL) ? &(stats->thread[id]) : NULL;
+}
+
+// start of a timed region
+static inline double probe_start(const struct ThreadStats *st) {
+    return (st != NULL) ? omp_get_wtime() : 0.0;
+}
+
+// n integrand calls made since start
+static inline void probe_eval(struct ThreadStats *st, long n, double start) {
+    if (st != NULL) {
+        st->evaluations += n;
+        st->eval_time += omp_get_wtime() - start;
+    }
+}
+
+// a lock acquired after waiting since start
+static inline void probe_lock(struct ThreadStats *st, double start) {
+    if (st != NULL) {
+        st->lock_time += omp_get_wtime() - start;
+    }
+}
+
+// no work found since start
+static inline void probe_idle(struct ThreadStats *st, double start) {
+    if (st != NULL) {
+        st->idle_time += omp_get_wtime() - start;
+    }
+}
+
+// n intervals processed
+static inline void probe_intervals(struct ThreadStats *st, long n) {
+    if (st != NULL) {
+        st->intervals += n;
+    }
+}
+
+// a queue, deque or heap seen holding depth entries
+static inline void probe_depth(struct ThreadStats *st, long depth) {
+    if (st != NULL && depth > st->max_depth) {
+        st->max_depth = depth;
+    }
+}
+
+// n tasks spawned
+static inline void probe_tasks(struct ThreadStats *st, long n) {
+    if (st != NULL) {
+        st->tasks += n;
+    }
+}
+
+// A run's budget: a copy of the caller's struct Budget, which the strategies
+// reach through Options.budget and update, and the bookkeeping derived from
+// its limits. budget comes first, so the probes can get from the
+// struct Budget * they are given back to the rest.
+struct Limits {
+    struct Budget budget;     // the caller's limits and the usage so far
+    double deadline;          // omp_get_wtime() at which max_time runs out
+    double min_width;         // narrowest interval that may be split
+};
+
+// Set up limits for a run over [a, b] under budget, with evaluations already
+// made, and return the budget to give the strategies, NULL if budget is NULL
+struct Budget *budget_begin(struct Limits *limits, const struct Budget *budget, double a, double b, long evaluations);
+
+// copy what the run used of limits back into the caller's budget, which may be NULL
+void budget_end(const struct Limits *limits, struct Budget *budget);
+
+// n integrand calls made
+static inline void budget_charge(struct Budget *budget, long n) {
+    if (budget != NULL) {
+        #pragma omp atomic
+        budget->evaluations += n;
+    }
+}
+
+// whether the evaluation or time limit has been reached
+static inline int budget_spent(struct Budget *budget) {
+    if (budget == NULL) {
+        return 0;
+    }
+    long evaluations;
+    #pragma omp atomic read
+    evaluations = budget->evaluations;
+    int spent = (budget->max_evaluations > 0 && evaluations >= budget->max_evaluations)
+             || (budget->max_time > 0.0 && omp_get_wtime() >= ((const struct Limits *) budget)->deadline);
+    if (spent) {
+        #pragma omp atomic write
+        budget->exhausted = 1;
+    }
+    return spent;
+}
+
+// whether an interval of width h is at the depth limit
+static inline int budget_floor(struct Budget *budget, double h) {
+    if (budget == NULL || h >= ((const struct Limits *) budget)->min_width) {
+        return 0;
+    }
+    #pragma omp atomic write
+    budget->exhausted = 1;
+    return 1;
+}
+
+// whether an unconverged interval of width h with error estimate err must be
+// accepted rather than split; if so its error is added to the budget's error
+static inline int budget_stop(struct Budget *budget, double h, double err) {
+    if (budget == NULL || !(budget_floor(budget, h) || budget_spent(budget))) {
+        return 0;
+    }
+    #pragma omp atomic
+    budget->error += err;
+    return 1;
+}
+
+// one trace event: a span, or an instant if dur is negative
+struct Event {
+    const char *name;            // event name, a string literal
+    double start;                // seconds since the trace began
+    double dur;                  // length of a span in seconds
+};
+
+// per-thread ring buffer, padded so that each thread owns its cache line
+struct TraceBuffer {
+    _Alignas(64) long count;     // events recorded, including overwritten ones
+    struct Event *event;         // ring of capacity events
+};
+
+struct Trace {
+    int num_threads;             // threads of the last run
+    long capacity;               // events kept per thread
+    double origin;               // omp_get_wtime() when the last run began
+    struct TraceBuffer *thread;  // one buffer per thread
+};
+
+// clear a trace for a run on num_threads threads
+void trace_begin(struct Trace *trace, int num_threads);
+
+// trace buffer of thread id, or NULL when tracing is off
+static inline struct TraceBuffer *thread_trace(struct Trace *trace, int id) {
+    return (trace != NULL) ? &(trace->thread[id]) : NULL;
+}
+
+// start of a traced span
+static inline double trace_start(const struct TraceBuffer *tb) {
+    return (tb != NULL) ? omp_get_wtime() : 0.0;
+}
+
+// record an event in a thread's ring buffer
+static inline void trace_record(struct TraceBuffer *tb, struct Trace *trace, const char *name, double start, double dur) {
+    struct Event *e = &(tb->event[tb->count % trace->capacity]);
+    e->name = name;
+    e->start = start - trace->origin;
+    e->dur = dur;
+    tb->count++;
+}
+
+// a span that began at start and ends now
+static inline void trace_span(struct TraceBuffer *tb, struct Trace *trace, const char *name, double start) {
+    if (tb != NULL) {
+        trace_record(tb, trace, name, start, omp_get_wtime() - start);
+    }
+}
+
+// an instant event
+static inline void trace_instant(struct TraceBuffer *tb, struct Trace *trace, const char *name) {
+    if (tb != NULL) {
+        trace_record(tb, trace, name, omp_get_wtime(), -1.0);
+    }
+}
+
+// work done by one thread, updated by that thread only and read by
+// progress_read() from any thread; padded so that each thread owns its cache line
+// An interval adds its error estimate to pending when it is split, and takes
+// its own share of its parent's estimate off when it is evaluated, so the
+// sum of pending over all slots is the estimate over the intervals still
+// queued or in flight. Slots of single threads can go negative.
+struct ProgressSlot {
+    _Alignas(64) _Atomic double quad;  // sum of the estimates of its converged intervals
+    _Atomic double width;              // sum of their widths
+    _Atomic double pending;            // its contribution to the pending error estimate
+    _Atomic long leaves;               // number of converged intervals
+};
+
+struct Progress {
+    void (*callback)(const struct Snapshot *, void *); // called on publication, or NULL
+    void *arg;                   // second argument of callback
+    long every_leaves;           // converged intervals between publications, 0 for never
+    double every_seconds;        // seconds between publications, 0 for never
+    int num_threads;             // threads of the current run
+    struct ProgressSlot *thread; // one slot per thread
+    double width;                // width of the domain of the current run
+    double start;                // omp_get_wtime() at the start of the current run
+    long stride;                 // leaves of one thread between publications
+    _Atomic double next_time;    // omp_get_wtime() of the next timed publication
+    _Atomic int publishing;      // set while a thread is calling callback
+};
+
+// clear progress for a run over [a, b] on num_threads threads
+void progress_begin(struct Progress *progress, int num_threads, double a, double b);
+
+// pass a snapshot to the callback, unless another thread is already doing so
+void progress_publish(struct Progress *progress);
+
+// add value to one of a thread's own progress fields
+static inline void progress_add(_Atomic double *field, double value) {
+    // Only this thread writes the slot, so relaxed load-add-store is enough
+    atomic_store_explicit(field, atomic_load_explicit(field, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+// interval with its parent's error share split on thread id, with error estimate err
+static inline void progress_split(struct Progress *progress, int id, double share, double err) {
+    if (progress != NULL) {
+        progress_add(&(progress->thread[id].pending), err - share);
+    }
+}
+
+// converged interval of width h with estimate quad and its parent's error share on thread id
+static inline void progress_leaf(struct Progress *progress, int id, double h, double quad, double share) {
+    if (progress == NULL) {
+        return;
+    }
+    struct ProgressSlot *slot = &(progress->thread[id]);
+    progress_add(&(slot->quad), quad);
+    progress_add(&(slot->width), h);
+    progress_add(&(slot->pending), -share);
+    long leaves = atomic_load_explicit(&(slot->leaves), memory_order_relaxed) + 1;
+    atomic_store_explicit(&(slot->leaves), leaves, memory_order_relaxed);
+
+    if (progress->callback == NULL) {
+        return;
+    }
+    // The clock is only read every 64 leaves
+    if ((progress->stride > 0 && leaves % progress->stride == 0)
+        || (progress->every_seconds > 0.0 && leaves % 64 == 0
+            && omp_get_wtime() >= atomic_load_explicit(&(progress->next_time), memory_order_relaxed))) {
+        progress_publish(progress);
+    }
+}
+
+#endif
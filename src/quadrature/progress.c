@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "probe.h"
+#include "progress.h"
+
+struct Progress *progress_create(void (*callback)(const struct Snapshot *, void *), void *arg,
+                                 long every_leaves, double every_seconds) {
+    struct Progress *progress = malloc(sizeof(struct Progress));
+    if (progress == NULL) {
+        printf("Unable to allocate progress - exiting\n");
+        exit(1);
+    }
+    progress->callback = callback;
+    progress->arg = arg;
+    progress->every_leaves = every_leaves;
+    progress->every_seconds = every_seconds;
+    progress->num_threads = 0;
+    progress->thread = NULL;
+    progress->width = 0.0;
+    progress->start = 0.0;
+    progress->stride = 0;
+    atomic_init(&(progress->next_time), 0.0);
+    atomic_init(&(progress->publishing), 0);
+    return progress;
+}
+
+void progress_begin(struct Progress *progress, int num_threads, double a, double b) {
+    if (num_threads > progress->num_threads) {
+        free(progress->thread);
+        progress->thread = aligned_alloc(64, num_threads * sizeof(struct ProgressSlot));
+        if (progress->thread == NULL) {
+            printf("Unable to allocate progress - exiting\n");
+            exit(1);
+        }
+    }
+    for (int i = 0; i < num_threads; i++) {
+        atomic_init(&(progress->thread[i].quad), 0.0);
+        atomic_init(&(progress->thread[i].width), 0.0);
+        atomic_init(&(progress->thread[i].pending), 0.0);
+        atomic_init(&(progress->thread[i].leaves), 0);
+    }
+    progress->num_threads = num_threads;
+    progress->width = (b > a) ? b - a : a - b;
+    progress->start = omp_get_wtime();
+    // Each thread publishes after its share of every_leaves
+    progress->stride = (progress->every_leaves > 0) ? progress->every_leaves / num_threads : 0;
+    if (progress->every_leaves > 0 && progress->stride < 1) {
+        progress->stride = 1;
+    }
+    atomic_store(&(progress->next_time), progress->start + progress->every_seconds);
+    atomic_store(&(progress->publishing), 0);
+}
+
+void progress_read(const struct Progress *progress, struct Snapshot *snapshot) {
+    double width = 0.0;
+
+    snapshot->quad = 0.0;
+    snapshot->error = 0.0;
+    snapshot->leaves = 0;
+    for (int i = 0; i < progress->num_threads; i++) {
+        const struct ProgressSlot *slot = &(progress->thread[i]);
+        snapshot->quad += atomic_load_explicit(&(slot->quad), memory_order_relaxed);
+        snapshot->error += atomic_load_explicit(&(slot->pending), memory_order_relaxed);
+        snapshot->leaves += atomic_load_explicit(&(slot->leaves), memory_order_relaxed);
+        width += atomic_load_explicit(&(slot->width), memory_order_relaxed);
+    }
+    snapshot->covered = (progress->width > 0.0) ? width / progress->width : 1.0;
+    snapshot->time = omp_get_wtime() - progress->start;
+}
+
+void progress_publish(struct Progress *progress) {
+    struct Snapshot snapshot;
+
+    // One thread publishes at a time; the others carry on rather than wait
+    if (atomic_exchange(&(progress->publishing), 1) != 0) {
+        return;
+    }
+    atomic_store(&(progress->next_time), omp_get_wtime() + progress->every_seconds);
+    progress_read(progress, &snapshot);
+    progress->callback(&snapshot, progress->arg);
+    atomic_store(&(progress->publishing), 0);
+}
+
+void progress_free(struct Progress *progress) {
+    if (progress != NULL) {
+        free(progress->thread);
+        free(progress);
+    }
+}
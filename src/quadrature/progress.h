@@ -0,0 +1,36 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+// Opt-in progressive results. Point Options.progress at a struct Progress
+// from progress_create() and every converged interval is added to its
+// thread's slot with relaxed atomic stores, as is the error estimate of the
+// part that has not converged yet. progress_read() sums the slots
+// from any thread while the run continues, without locks and without
+// stopping the workers, and a callback can be invoked by the workers every
+// so many leaves or seconds. Supported by STRATEGY_SERIAL, RECURSIVE, LIFO,
+// WORK_STEALING, BATCHED and MULTI_QUEUE.
+
+// estimate of a run in flight
+struct Snapshot {
+    double quad;                 // integral over the converged part of [a, b]
+    double covered;              // fraction of [a, b] that has converged
+    double error;                // estimated error of the part still pending, 0 until the first split
+    long leaves;                 // converged intervals
+    double time;                 // seconds since the run started
+};
+
+struct Progress;
+
+// progress reporting that calls callback(snapshot, arg) from a worker thread
+// about every every_leaves converged intervals and every every_seconds
+// seconds, either 0 for never; callback may be NULL to only poll
+struct Progress *progress_create(void (*callback)(const struct Snapshot *, void *), void *arg,
+                                 long every_leaves, double every_seconds);
+
+// current estimate of the run using progress, consistent per thread but not across threads
+void progress_read(const struct Progress *progress, struct Snapshot *snapshot);
+
+// release progress reporting
+void progress_free(struct Progress *progress);
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef QUADRATURE_H
+#define QUADRATURE_H
+
+#define MAXBATCH 64 // largest batch_size accepted by STRATEGY_BATCHED
+
+struct Cache;
+struct Stats;
+struct Trace;
+struct Progress;
+
+// scheduling strategy used by integrate()
+enum Strategy {
+    STRATEGY_SERIAL,        // one thread, explicit stack
+    STRATEGY_RECURSIVE,     // recursive OpenMP tasks with an adaptive cutoff
+    STRATEGY_LIFO,          // one shared LIFO stack protected by a lock
+    STRATEGY_WORK_STEALING, // per-thread Chase-Lev deques with stealing
+    STRATEGY_BATCHED,       // work stealing, evaluating several intervals per call
+    STRATEGY_PRIORITY,      // refine the largest error first until the total error is below tol
+    STRATEGY_BREADTH_FIRST, // refine one level of the tree at a time with omp for
+    STRATEGY_MULTI_QUEUE,   // locked stacks shared by all threads, random push, best-of-two pop
+    NUM_STRATEGIES
+};
+
+// rule applied to each interval
+enum Rule {
+    RULE_SIMPSON,           // 3-point against 5-point Simpson, reusing points across bisection
+    RULE_GK15,              // 15-point Kronrod with embedded 7-point Gauss
+    RULE_GK21,              // 21-point Kronrod with embedded 10-point Gauss
+    NUM_RULES
+};
+
+// limits on the work of one run, and what the run used of them (Options.budget)
+// Once a limit is reached, intervals that miss the tolerance are no longer
+// split: their current estimates are added to the result and their error
+// estimates to error, so the result is the best sum within the budget.
+// Intervals already queued are still evaluated once, so a run may overshoot
+// max_evaluations by a few evaluations per pending interval.
+struct Budget {
+    long max_evaluations;     // integrand calls before refinement stops, 0 for no limit
+    double max_time;          // seconds before refinement stops, 0 for no limit
+    int max_depth;            // bisections of [a, b] below which intervals are not split, 0 for no limit
+    // filled in by integrate()
+    long evaluations;         // integrand calls made
+    double error;             // summed error estimates of the intervals accepted without meeting tol
+                              // (STRATEGY_PRIORITY: of every interval, the global error estimate)
+    int exhausted;            // nonzero if a limit stopped refinement
+};
+
+struct Options {
+    enum Strategy strategy;   // scheduler to use
+    enum Rule rule;           // quadrature rule; Gauss-Kronrod rules are supported by STRATEGY_SERIAL,
+                              // RECURSIVE, LIFO, WORK_STEALING, BATCHED and MULTI_QUEUE
+    int num_threads;          // threads to run on, 0 for omp_get_max_threads()
+    int numa;                 // STRATEGY_LIFO, STRATEGY_WORK_STEALING: bind threads with proc_bind(close),
+                              // keep one queue per NUMA domain (LIFO) and steal within a domain first
+    int tasks_per_thread;     // STRATEGY_RECURSIVE: pending tasks per thread before splits run inline
+    int batch_size;           // STRATEGY_BATCHED: intervals evaluated together, at most MAXBATCH
+    int queues_per_thread;    // STRATEGY_MULTI_QUEUE: stacks in the frontier per thread
+    void (*batch_func)(const double *, double *, int); // STRATEGY_BATCHED, STRATEGY_BREADTH_FIRST:
+                                                       // integrand evaluated at n points,
+                                                       // or NULL to call func once per point
+    struct Cache *cache;      // integrand values kept between runs (see cache.h), or NULL
+    const char *checkpoint;   // STRATEGY_BREADTH_FIRST: file the frontier is saved to, or NULL;
+                              // other strategies exit if it is set
+    double checkpoint_interval; // seconds between checkpoints
+    struct Stats *stats;      // per-thread counters filled in by integrate() (see stats.h), or NULL
+    struct Trace *trace;      // per-thread event timeline recorded by integrate() (see trace.h), or NULL
+    struct Budget *budget;    // limits on evaluations, time and depth, or NULL; not supported by
+                              // STRATEGY_BREADTH_FIRST
+    struct Progress *progress; // intermediate results published during the run (see progress.h), or NULL
+};
+
+// fill in the default options (work stealing on all available threads)
+void default_options(struct Options *opts);
+
+// integrate func over [a, b] to tolerance tol by adaptive quadrature with opts->rule
+// tol bounds the error of each converged interval, except for STRATEGY_PRIORITY
+// where it bounds the summed error estimate over the whole domain.
+// opts may be NULL to use the defaults
+double integrate(double (*func)(double), double a, double b, double tol, const struct Options *opts);
+
+// continue a STRATEGY_BREADTH_FIRST run from the last complete checkpoint in path
+// func must be the integrand of the original run. If opts->checkpoint is
+// set, further checkpoints replace the file as before. opts->stats and
+// opts->trace cover the resumed part of the run; budgets, progress and
+// caches are not supported. opts may be NULL.
+double integrate_resume(double (*func)(double), const char *path, const struct Options *opts);
+
+// one integral in a batch passed to integrate_many()
+struct Problem {
+    double a, b;  // domain
+    double tol;   // tolerance
+    double param; // second argument passed to the integrand
+};
+
+// integrate func(x, problems[i].param) over [problems[i].a, problems[i].b] for
+// every i < n, storing the integrals in results
+// All problems share one work-stealing frontier, so the threads stay busy
+// until the last problem finishes. opts->num_threads is used, opts may be NULL.
+void integrate_many(double (*func)(double, double), const struct Problem *problems, double *results, int n,
+                    const struct Options *opts);
+
+// name of a strategy, as accepted by parse_strategy()
+const char *strategy_name(enum Strategy strategy);
+
+// look up a strategy by name, returns 0 if the name is not recognised
+int parse_strategy(const char *name, enum Strategy *strategy);
+
+// name of a rule, as accepted by parse_rule()
+const char *rule_name(enum Rule rule);
+
+// look up a rule by name, returns 0 if the name is not recognised
+int parse_rule(const char *name, enum Rule *rule);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef QUADRATURE_MPI_H
+#define QUADRATURE_MPI_H
+
+#include <mpi.h>
+#include "quadrature.h"
+
+// Hybrid MPI + OpenMP integration of func over [a, b] to tolerance tol.
+// Every rank of comm must call this with the same arguments. Each rank
+// refines its part of the frontier breadth-first with its OpenMP threads;
+// after every level the frontier is rebalanced across the ranks so that
+// none of them runs dry while others still have work.
+// The result is returned on every rank. MPI must be initialised with at
+// least MPI_THREAD_FUNNELED. Only Simpson's rule is supported, and opts
+// must not set a budget, progress, stats, a trace, a cache or a checkpoint.
+double integrate_mpi(double (*func)(double), double a, double b, double tol, const struct Options *opts, MPI_Comm comm);
+
+#endif
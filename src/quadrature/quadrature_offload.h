@@ -0,0 +1,18 @@
+#ifndef QUADRATURE_OFFLOAD_H
+#define QUADRATURE_OFFLOAD_H
+
+#include "quadrature.h"
+
+// Integrate func1 over [a, b] to tolerance tol on an OpenMP offload device.
+// The breadth-first frontier stays in device memory and only the sum comes
+// back. Device code cannot call through a host function pointer, so the
+// integrand is fixed to func1, which function.h marks declare target.
+// device selects the device; if it is negative the default device is used,
+// or, when there is none, integrate(func1, a, b, tol, opts) runs on the CPU.
+// Passing omp_get_initial_device() runs the same kernels on the host.
+// The kernels use Simpson's rule, so on a device opts, which may be NULL,
+// must not select another rule or set a budget, progress, stats, a trace,
+// a cache or a checkpoint.
+double integrate_offload(double a, double b, double tol, int device, const struct Options *opts);
+
+#endif
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "probe.h"
+#include "records.h"
+
+#define STACKSIZE 64 // initial number of records per stack
+
+void records_init(struct RecordStack *stack, size_t size) {
+    stack->record = malloc(STACKSIZE * size);
+    if (stack->record == NULL) {
+        printf("Unable to allocate queue storage - exiting\n");
+        exit(1);
+    }
+    stack->size = size;
+    stack->first = 0;
+    stack->last = 0;
+    stack->capacity = STACKSIZE;
+    omp_init_lock(&(stack->lock));
+}
+
+void records_destroy(struct RecordStack *stack) {
+    free(stack->record);
+    omp_destroy_lock(&(stack->lock));
+}
+
+void *records_reserve(struct RecordStack *stack, int count) {
+    if (stack->last + count > stack->capacity) {
+        long pending = stack->last - stack->first;
+        if (stack->first < count || stack->first <= stack->capacity / 2) {
+            // Full, replace the storage with twice as much
+            char *bigger = malloc(2 * stack->capacity * stack->size);
+            if (bigger == NULL) {
+                printf("Unable to allocate queue storage - exiting\n");
+                exit(1);
+            }
+            memcpy(bigger, stack->record + stack->first * stack->size, pending * stack->size);
+            free(stack->record);
+            stack->record = bigger;
+            stack->capacity *= 2;
+        } else {
+            // Mostly stolen from the bottom, move the pending records down
+            memmove(stack->record, stack->record + stack->first * stack->size, pending * stack->size);
+        }
+        stack->first = 0;
+        stack->last = pending;
+    }
+    stack->last += count;
+    return stack->record + (stack->last - count) * stack->size;
+}
+
+void records_push(struct RecordStack *stack, const void *record, struct ThreadStats *st) {
+    double t = probe_start(st);
+    omp_set_lock(&(stack->lock));
+    probe_lock(st, t);
+    memcpy(records_reserve(stack, 1), record, stack->size);
+    probe_depth(st, stack->last - stack->first);
+    omp_unset_lock(&(stack->lock));
+}
+
+int records_pop(struct RecordStack *stack, void *record, int from_top, struct ThreadStats *st) {
+    double t = probe_start(st);
+    omp_set_lock(&(stack->lock));
+    probe_lock(st, t);
+    int found = (stack->last > stack->first);
+    if (found) {
+        long i = from_top ? --stack->last : stack->first++;
+        memcpy(record, stack->record + i * stack->size, stack->size);
+    }
+    if (stack->last == stack->first) {
+        stack->first = stack->last = 0;
+    }
+    omp_unset_lock(&(stack->lock));
+    return found;
+}
@@ -0,0 +1,38 @@
+#ifndef RECORDS_H
+#define RECORDS_H
+
+#include <stddef.h>
+#include <omp.h>
+
+struct ThreadStats;
+
+// Locked two-ended stack of fixed-size records, shared by the cubature and
+// vector solvers, whose pending work does not fit struct Interval. The
+// owner works at the top; thieves take the oldest record from the bottom.
+struct RecordStack {
+    char *record;       // records first .. last - 1 are pending
+    size_t size;        // bytes per record
+    long first;         // oldest (and therefore largest) pending record
+    long last;          // one past the newest pending record
+    long capacity;      // allocated number of records
+    omp_lock_t lock;    // lock for synchronization
+};
+
+// initialise stack for records of size bytes
+void records_init(struct RecordStack *stack, size_t size);
+
+// release stack storage
+void records_destroy(struct RecordStack *stack);
+
+// reserve count records at the top, growing the stack if full, and return
+// the first; the caller holds stack->lock or is the only thread using it
+void *records_reserve(struct RecordStack *stack, int count);
+
+// copy one record to the top of the stack
+void records_push(struct RecordStack *stack, const void *record, struct ThreadStats *st);
+
+// take the newest record (from_top) or the oldest one into record
+// returns 0 if the stack is empty
+int records_pop(struct RecordStack *stack, void *record, int from_top, struct ThreadStats *st);
+
+#endif
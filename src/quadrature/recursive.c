@@ -0,0 +1,138 @@
+#include <math.h>
+#include <omp.h>
+#include "probe.h"
+#include "rule.h"
+#include "solvers.h"
+
+// state shared by every task of one recursive integration
+struct Recursive {
+    double (*func)(double);   // integrand
+    const struct GKRule *gk;  // Gauss-Kronrod pair, or NULL for Simpson's rule
+    int pending;              // tasks created but not yet started
+    int max_pending;          // cutoff above which no new tasks are created
+    struct Stats *stats;      // per-thread counters, or NULL
+    struct Trace *trace;      // per-thread event timeline, or NULL
+    struct Budget *budget;    // limits on the run, or NULL
+    struct Progress *progress; // progressive results, or NULL
+};
+
+static double simpson(struct Recursive *state, struct Interval interval) {
+    // Already have function evaluations at each end of the interval and in the middle
+    // Now get function values at one-quarter and three-quarter points
+    double h = interval.right - interval.left;
+    double c = (interval.left + interval.right) / 2.0;
+    double d = (interval.left + c) / 2.0;
+    double e = (c + interval.right) / 2.0;
+    // Tasks migrate between threads, so look up the counters on every call
+    struct ThreadStats *st = thread_stats(state->stats, omp_get_thread_num());
+    struct TraceBuffer *tb = thread_trace(state->trace, omp_get_thread_num());
+    double fd = 0.0, fe = 0.0, quad, err;
+    double t = probe_start(st);
+    if (state->gk == NULL) {
+        // Compute integral estimates using 3 and 5 points respectively
+        fd = state->func(d);
+        fe = state->func(e);
+        probe_eval(st, 2, t);
+        double q1 = h / 6.0 * (interval.f_left + 4.0 * interval.f_mid + interval.f_right);
+        double q2 = h / 12.0 * (interval.f_left + 4.0 * fd + 2.0 * interval.f_mid + 4.0 * fe + interval.f_right);
+        err = fabs(q2 - q1);
+        quad = q2 + (q2 - q1) / 15.0;
+    } else {
+        // Kronrod estimate, none of whose nodes are reused by the subintervals
+        quad = gk_apply(state->gk, state->func, interval.left, interval.right, &err);
+        probe_eval(st, 2 * state->gk->n + 1, t);
+    }
+    probe_intervals(st, 1);
+    budget_charge(state->budget, (state->gk == NULL) ? 2 : 2 * state->gk->n + 1);
+
+    if ((err < interval.tol) || (h < 1.0e-12) || budget_stop(state->budget, h, err)) {
+        // Tolerance is met, interval is small enough or the budget is spent, return
+        // Add an error correction term to the more accurate estimate (q2)
+        trace_instant(tb, state->trace, "leaf");
+        progress_leaf(state->progress, omp_get_thread_num(), h, quad, interval.share);
+        return quad;
+    } else {
+        // Tolerance is not met, split interval in two and make recursive calls
+        struct Interval i1, i2;
+        double quad1, quad2;
+        int queued;
+
+        // Set up the left and right subintervals
+        split_interval(&interval, fd, fe, err, &i1, &i2);
+        progress_split(state->progress, omp_get_thread_num(), interval.share, err);
+
+        #pragma omp atomic read
+        queued = state->pending;
+
+        if (queued < state->max_pending) {
+            // Idle threads may be waiting for work, so create OpenMP tasks
+            #pragma omp atomic
+            state->pending += 2;
+            probe_tasks(st, 2);
+            probe_depth(st, queued + 2);
+
+            #pragma omp task shared(quad1)
+            {
+                #pragma omp atomic
+                state->pending--;
+                // Recursively compute the integral for the left subinterval
+                struct TraceBuffer *run = thread_trace(state->trace, omp_get_thread_num());
+                double start = trace_start(run);
+                quad1 = simpson(state, i1);
+                trace_span(run, state->trace, "task", start);
+            }
+            trace_instant(tb, state->trace, "spawn");
+
+            #pragma omp task shared(quad2)
+            {
+                #pragma omp atomic
+                state->pending--;
+                // Recursively compute the integral for the right subinterval
+                struct TraceBuffer *run = thread_trace(state->trace, omp_get_thread_num());
+                double start = trace_start(run);
+                quad2 = simpson(state, i2);
+                trace_span(run, state->trace, "task", start);
+            }
+            trace_instant(tb, state->trace, "spawn");
+
+            // Wait for the tasks to complete before proceeding
+            double wait = trace_start(tb);
+            #pragma omp taskwait
+            trace_span(tb, state->trace, "taskwait", wait);
+        } else {
+            // Enough tasks are already waiting to keep every thread busy,
+            // so compute the integrals sequentially
+            quad1 = simpson(state, i1);
+            quad2 = simpson(state, i2);
+        }
+
+        // Return the sum of the integrals over the subintervals
+        return quad1 + quad2;
+    }
+}
+
+double integrate_recursive(double (*func)(double), struct Interval whole, const struct Options *opts, int num_threads) {
+    struct Recursive state;
+    double quad;
+
+    state.func = func;
+    state.gk = gk_rule(opts->rule);
+    state.pending = 0;
+    state.stats = opts->stats;
+    state.trace = opts->trace;
+    state.budget = opts->budget;
+    state.progress = opts->progress;
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        // Tasks may run on any thread of the team
+        cache_enter(opts->cache);
+        #pragma omp single
+        {
+            state.max_pending = opts->tasks_per_thread * omp_get_num_threads();
+            quad = simpson(&state, whole);
+        }
+    }
+
+    return quad;
+}
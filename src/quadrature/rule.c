@@ -0,0 +1,74 @@
+#include <math.h>
+#include <stddef.h>
+#include "kronrod.h"
+#include "rule.h"
+
+static const struct GKRule rules[] = {
+    {7, xk15, wk15, wg7, 1},
+    {10, xk21, wk21, wg10, 0}
+};
+
+const struct GKRule *gk_rule(enum Rule rule) {
+    switch (rule) {
+    case RULE_GK15:
+        return &rules[0];
+    case RULE_GK21:
+        return &rules[1];
+    default:
+        return NULL;
+    }
+}
+
+// fill x with the 2n + 1 nodes of [left, right]: centre first, then pairs
+static void nodes(const struct GKRule *rule, double left, double right, double *x) {
+    double centre = (left + right) / 2.0, half = (right - left) / 2.0;
+    x[0] = centre;
+    for (int j = 0; j < rule->n; j++) {
+        x[2 * j + 1] = centre - half * rule->xk[j];
+        x[2 * j + 2] = centre + half * rule->xk[j];
+    }
+}
+
+// combine the function values at the nodes into the two estimates
+static double combine(const struct GKRule *rule, double left, double right, const double *fx, double *err) {
+    double half = (right - left) / 2.0;
+    double kronrod = rule->wk[rule->n] * fx[0];
+    double gauss = rule->gauss_centre ? rule->wg[rule->n / 2] * fx[0] : 0.0;
+    for (int j = 0; j < rule->n; j++) {
+        double pair = fx[2 * j + 1] + fx[2 * j + 2];
+        kronrod += rule->wk[j] * pair;
+        if (j % 2 == 1) {
+            gauss += rule->wg[j / 2] * pair;
+        }
+    }
+    *err = fabs((kronrod - gauss) * half);
+    return kronrod * half;
+}
+
+double gk_apply(const struct GKRule *rule, double (*func)(double), double left, double right, double *err) {
+    double x[GK_MAXPOINTS], fx[GK_MAXPOINTS];
+    int m = 2 * rule->n + 1;
+
+    nodes(rule, left, right, x);
+    for (int k = 0; k < m; k++) {
+        fx[k] = func(x[k]);
+    }
+    return combine(rule, left, right, fx, err);
+}
+
+void gk_apply_batch(const struct GKRule *rule, void (*batch_func)(const double *, double *, int),
+                    const double *left, const double *right, int n, double *quad, double *err) {
+    double x[MAXBATCH * GK_MAXPOINTS], fx[MAXBATCH * GK_MAXPOINTS];
+    int m = 2 * rule->n + 1;
+
+    if (n < 1) {
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        nodes(rule, left[i], right[i], &x[i * m]);
+    }
+    batch_func(x, fx, n * m);
+    for (int i = 0; i < n; i++) {
+        quad[i] = combine(rule, left[i], right[i], &fx[i * m], &err[i]);
+    }
+}
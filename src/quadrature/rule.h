@@ -0,0 +1,34 @@
+#ifndef RULE_H
+#define RULE_H
+
+#include "quadrature.h"
+
+#define GK_MAXPOINTS 21 // nodes of the largest Gauss-Kronrod rule
+#define GK15_NODES 7    // positive Kronrod nodes of RULE_GK15, excluding the centre
+#define GK21_NODES 10   // positive Kronrod nodes of RULE_GK21, excluding the centre
+
+// Gauss-Kronrod pair on [-1, 1], in the QUADPACK layout: xk[j] for j < n
+// are the positive nodes, largest first, with the Gauss nodes at odd j and
+// the centre at xk[n]. The Gauss rule includes the centre only if it has
+// an odd number of nodes, in which case its weight is wg[n / 2].
+struct GKRule {
+    int n;                  // positive Kronrod nodes, excluding the centre
+    const double *xk;       // Kronrod nodes, n + 1 values
+    const double *wk;       // Kronrod weights, n + 1 values
+    const double *wg;       // Gauss weights
+    int gauss_centre;       // whether the centre is also a Gauss node
+};
+
+// the pair used by a rule, or NULL for RULE_SIMPSON
+const struct GKRule *gk_rule(enum Rule rule);
+
+// Kronrod estimate of the integral of func over [left, right]; *err is set
+// to its difference from the embedded Gauss estimate
+double gk_apply(const struct GKRule *rule, double (*func)(double), double left, double right, double *err);
+
+// gk_apply() for n intervals at once, evaluating all of their nodes in one
+// call of batch_func (n at most MAXBATCH)
+void gk_apply_batch(const struct GKRule *rule, void (*batch_func)(const double *, double *, int),
+                    const double *left, const double *right, int n, double *quad, double *err);
+
+#endif
@@ -0,0 +1,78 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "accumulator.h"
+#include "probe.h"
+#include "rule.h"
+#include "solvers.h"
+
+#define STACKSIZE 64 // initial number of pending intervals
+
+double integrate_serial(double (*func)(double), struct Interval whole, const struct Options *opts) {
+    const struct GKRule *gk = (opts != NULL) ? gk_rule(opts->rule) : NULL;
+    struct Stats *stats = (opts != NULL) ? opts->stats : NULL;
+    struct Budget *budget = (opts != NULL) ? opts->budget : NULL;
+    struct Progress *progress = (opts != NULL) ? opts->progress : NULL;
+    struct Accumulator *acc = new_accumulators(1);
+    struct ThreadStats *st = thread_stats(stats, 0);
+    int capacity = STACKSIZE;
+    int top = 0;
+    struct Interval *stack = malloc(capacity * sizeof(struct Interval));
+
+    if (stack == NULL) {
+        printf("Unable to allocate queue storage - exiting\n");
+        exit(1);
+    }
+    stack[0] = whole;
+
+    // Depth-first over an explicit stack, so no thread or task is needed
+    while (top >= 0) {
+        struct Interval interval = stack[top--];
+        double h = interval.right - interval.left;
+        double c = (interval.left + interval.right) / 2.0;
+        double d = (interval.left + c) / 2.0;
+        double e = (c + interval.right) / 2.0;
+        double fd = 0.0, fe = 0.0, quad, err;
+        double t = probe_start(st);
+        if (gk == NULL) {
+            // Calculate integral estimates using 3 and 5 points respectively
+            fd = func(d);
+            fe = func(e);
+            probe_eval(st, 2, t);
+            double q1 = h / 6.0 * (interval.f_left + 4.0 * interval.f_mid + interval.f_right);
+            double q2 = h / 12.0 * (interval.f_left + 4.0 * fd + 2.0 * interval.f_mid + 4.0 * fe + interval.f_right);
+            err = fabs(q2 - q1);
+            quad = q2 + (q2 - q1) / 15.0;
+        } else {
+            // Kronrod estimate, none of whose nodes are reused by the subintervals
+            quad = gk_apply(gk, func, interval.left, interval.right, &err);
+            probe_eval(st, 2 * gk->n + 1, t);
+        }
+        probe_intervals(st, 1);
+        budget_charge(budget, (gk == NULL) ? 2 : 2 * gk->n + 1);
+
+        if ((err < interval.tol) || (h < 1.0e-12) || budget_stop(budget, h, err)) {
+            // Tolerance is met or the budget is spent, add to total
+            accumulate(acc, interval.left, quad);
+            progress_leaf(progress, 0, h, quad, interval.share);
+        } else {
+            // Tolerance is not met, split interval in two and push both halves
+            if (top + 2 >= capacity) {
+                capacity *= 2;
+                stack = realloc(stack, capacity * sizeof(struct Interval));
+                if (stack == NULL) {
+                    printf("Unable to allocate queue storage - exiting\n");
+                    exit(1);
+                }
+            }
+
+            split_interval(&interval, fd, fe, err, &stack[top + 2], &stack[top + 1]);
+            progress_split(progress, 0, interval.share, err);
+            top += 2;
+            probe_depth(st, top + 1);
+        }
+    }
+
+    free(stack);
+    return reduce(acc, 1);
+}
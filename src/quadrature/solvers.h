@@ -0,0 +1,37 @@
+#ifndef SOLVERS_H
+#define SOLVERS_H
+
+#include "interval.h"
+#include "quadrature.h"
+
+// Strategy entry points called by integrate(). Each one is given the whole
+// interval with its three function values already evaluated.
+
+// Prepare cache for a run of func over [a, b]. Replaces opts->batch_func
+// with a cached version and returns the cached func.
+double (*cache_bind(struct Cache *cache, double (*func)(double), struct Options *opts, double a, double b))(double);
+
+// Make cache the one the cached integrand uses on the calling thread and
+// return the previous one. integrate() sets it around each run and every
+// parallel region of a strategy sets it on its own threads, so concurrent
+// runs with different caches do not mix.
+struct Cache *cache_enter(struct Cache *cache);
+
+// opts may be NULL for Simpson's rule without stats, budget or progress
+double integrate_serial(double (*func)(double), struct Interval whole, const struct Options *opts);
+
+double integrate_recursive(double (*func)(double), struct Interval whole, const struct Options *opts, int num_threads);
+
+double integrate_lifo(double (*func)(double), struct Interval whole, const struct Options *opts, int num_threads);
+
+double integrate_work_stealing(double (*func)(double), struct Interval whole, const struct Options *opts, int num_threads);
+
+double integrate_batched(double (*func)(double), struct Interval whole, const struct Options *opts, int num_threads);
+
+double integrate_priority(double (*func)(double), struct Interval whole, const struct Options *opts, int num_threads);
+
+double integrate_breadth_first(double (*func)(double), struct Interval whole, const struct Options *opts, int num_threads);
+
+double integrate_multi_queue(double (*func)(double), struct Interval whole, const struct Options *opts, int num_threads);
+
+#endif
@@ -0,0 +1,213 @@
+// Solver specialised at compile time for one integrand, rule and scheduler.
+// This file is a template: each inclusion generates one solver.
+//
+//     static double smooth(double x) { return exp(x); }
+//
+//     #define SPECIALISE_NAME integrate_smooth          // name of the generated solver
+//     #define SPECIALISE_FUNC smooth                    // integrand, defined above
+//     #define SPECIALISE_RULE RULE_GK21                 // optional, RULE_SIMPSON by default
+//     #define SPECIALISE_SCHEDULER SPECIALISE_SERIAL    // optional, SPECIALISE_WORK_STEALING by default
+//     #include "specialise.h"
+//
+// defines
+//
+//     static double integrate_smooth(double a, double b, double tol, const struct Options *opts);
+//
+// which gives the same result as integrate() with the matching strategy and
+// rule. The integrand is called directly rather than through a pointer, and
+// the Gauss-Kronrod nodes and weights are constants from kronrod.h, so the
+// compiler can inline the integrand and unroll and vectorise the node loop.
+// The work-stealing scheduler is the loop of steal.h, shared with
+// integrate_work_stealing(). Only num_threads and
+// stats are taken from opts, which may be NULL. integrate() remains the entry
+// point for integrands only known at run time.
+
+#ifndef SPECIALISE_H
+#define SPECIALISE_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "accumulator.h"
+#include "kronrod.h"
+#include "probe.h"
+#include "rule.h"
+#include "steal.h"
+
+#define SPECIALISE_SERIAL 0          // explicit stack on the calling thread
+#define SPECIALISE_WORK_STEALING 1   // per-thread Chase-Lev deques
+
+#define SPECIALISE_JOIN(a, b) SPECIALISE_JOIN2(a, b)
+#define SPECIALISE_JOIN2(a, b) a##b
+
+#endif
+
+#ifndef SPECIALISE_NAME
+#error "SPECIALISE_NAME must be defined before including specialise.h"
+#endif
+#ifndef SPECIALISE_FUNC
+#error "SPECIALISE_FUNC must be defined before including specialise.h"
+#endif
+#ifndef SPECIALISE_RULE
+#define SPECIALISE_RULE RULE_SIMPSON
+#endif
+#ifndef SPECIALISE_SCHEDULER
+#define SPECIALISE_SCHEDULER SPECIALISE_WORK_STEALING
+#endif
+
+#define SPECIALISE_ESTIMATE SPECIALISE_JOIN(SPECIALISE_NAME, _estimate)
+
+// Estimate with the integrand and rule fixed, see Estimate in steal.h
+static inline double SPECIALISE_ESTIMATE(const struct WorkStealing *state, const struct Interval *interval,
+                                         double *fd, double *fe, double *err) {
+    double h = interval->right - interval->left;
+    double c = (interval->left + interval->right) / 2.0;
+
+    (void) state;
+    if (SPECIALISE_RULE == RULE_SIMPSON) {
+        // Calculate integral estimates using 3 and 5 points respectively
+        *fd = SPECIALISE_FUNC((interval->left + c) / 2.0);
+        *fe = SPECIALISE_FUNC((c + interval->right) / 2.0);
+        double q1 = h / 6.0 * (interval->f_left + 4.0 * interval->f_mid + interval->f_right);
+        double q2 = h / 12.0 * (interval->f_left + 4.0 * *fd + 2.0 * interval->f_mid + 4.0 * *fe + interval->f_right);
+        *err = fabs(q2 - q1);
+        return q2 + (q2 - q1) / 15.0;
+    }
+
+    // Node count, layout and tables are fixed by the rule, see rule.h
+    const int n = (SPECIALISE_RULE == RULE_GK15) ? GK15_NODES : GK21_NODES;
+    const int gauss_centre = (SPECIALISE_RULE == RULE_GK15);
+    const double *xk = (SPECIALISE_RULE == RULE_GK15) ? xk15 : xk21;
+    const double *wk = (SPECIALISE_RULE == RULE_GK15) ? wk15 : wk21;
+    const double *wg = (SPECIALISE_RULE == RULE_GK15) ? wg7 : wg10;
+    double half = h / 2.0;
+    double fc = SPECIALISE_FUNC(c);
+    double kronrod = wk[n] * fc;
+    double gauss = gauss_centre ? wg[n / 2] * fc : 0.0;
+    for (int j = 0; j < n; j++) {
+        double pair = SPECIALISE_FUNC(c - half * xk[j]) + SPECIALISE_FUNC(c + half * xk[j]);
+        kronrod += wk[j] * pair;
+        if (j % 2 == 1) {
+            gauss += wg[j / 2] * pair;
+        }
+    }
+    *fd = 0.0;
+    *fe = 0.0;
+    *err = fabs((kronrod - gauss) * half);
+    return kronrod * half;
+}
+
+static double SPECIALISE_NAME(double a, double b, double tol, const struct Options *opts) {
+    struct Options defaults;
+    struct Interval whole;
+    const int simpson = (SPECIALISE_RULE == RULE_SIMPSON);
+    const long points = simpson ? 2 : 2 * ((SPECIALISE_RULE == RULE_GK15) ? GK15_NODES : GK21_NODES) + 1;
+
+    if (opts == NULL) {
+        default_options(&defaults);
+        opts = &defaults;
+    }
+#if SPECIALISE_SCHEDULER == SPECIALISE_SERIAL
+    int num_threads = 1;
+#else
+    int num_threads = (opts->num_threads > 0) ? opts->num_threads : omp_get_max_threads();
+#endif
+
+    double start = 0.0;
+    if (opts->stats != NULL) {
+        stats_begin(opts->stats, num_threads);
+        start = omp_get_wtime();
+        opts->stats->thread[0].evaluations = simpson ? 3 : 0;
+    }
+
+    // Set up the initial interval; Gauss-Kronrod rules do not use the end and mid points
+    whole.left = a;
+    whole.right = b;
+    whole.tol = tol;
+    whole.f_left = simpson ? SPECIALISE_FUNC(a) : 0.0;
+    whole.f_right = simpson ? SPECIALISE_FUNC(b) : 0.0;
+    whole.f_mid = simpson ? SPECIALISE_FUNC((a + b) / 2.0) : 0.0;
+    whole.share = 0.0;
+    whole.id = 0;
+
+    struct Accumulator *acc = new_accumulators(num_threads);
+
+#if SPECIALISE_SCHEDULER == SPECIALISE_SERIAL
+    // Depth-first over an explicit stack, as integrate_serial()
+    struct ThreadStats *st = thread_stats(opts->stats, 0);
+    int capacity = 64;
+    int top = 0;
+    struct Interval *stack = malloc(capacity * sizeof(struct Interval));
+
+    if (stack == NULL) {
+        printf("Unable to allocate queue storage - exiting\n");
+        exit(1);
+    }
+    stack[0] = whole;
+
+    while (top >= 0) {
+        struct Interval interval = stack[top--];
+        double fd, fe, err;
+        double t = probe_start(st);
+        double quad = SPECIALISE_ESTIMATE(NULL, &interval, &fd, &fe, &err);
+        probe_eval(st, points, t);
+        probe_intervals(st, 1);
+
+        if ((err < interval.tol) || ((interval.right - interval.left) < 1.0e-12)) {
+            // Tolerance is met, add to total
+            accumulate(acc, interval.left, quad);
+        } else {
+            // Tolerance is not met, split interval in two and push both halves
+            if (top + 2 >= capacity) {
+                capacity *= 2;
+                stack = realloc(stack, capacity * sizeof(struct Interval));
+                if (stack == NULL) {
+                    printf("Unable to allocate queue storage - exiting\n");
+                    exit(1);
+                }
+            }
+            split_interval(&interval, fd, fe, err, &stack[top + 2], &stack[top + 1]);
+            top += 2;
+            probe_depth(st, top + 1);
+        }
+    }
+    free(stack);
+#else
+    // Per-thread deques with stealing, as integrate_work_stealing()
+    struct WorkStealing state;
+
+    state.func = SPECIALISE_FUNC;
+    state.gk = gk_rule(SPECIALISE_RULE);
+    state.whole = whole;
+    state.deques = malloc(num_threads * sizeof(struct Deque));
+    state.acc = acc;
+    atomic_init(&(state.outstanding), 1);
+    state.domain = NULL;
+    state.num_domains = 1;
+    state.stats = opts->stats;
+    state.budget = NULL;
+    state.progress = NULL;
+    state.cache = NULL;
+    if (state.deques == NULL) {
+        printf("Unable to allocate deques - exiting\n");
+        exit(1);
+    }
+
+    #pragma omp parallel num_threads(num_threads)
+    steal_worker(&state, SPECIALISE_ESTIMATE, points);
+    free(state.deques);
+#endif
+
+    double quad = reduce(acc, num_threads);
+    if (opts->stats != NULL) {
+        opts->stats->time = omp_get_wtime() - start;
+    }
+    return quad;
+}
+
+#undef SPECIALISE_ESTIMATE
+#undef SPECIALISE_SCHEDULER
+#undef SPECIALISE_RULE
+#undef SPECIALISE_FUNC
+#undef SPECIALISE_NAME
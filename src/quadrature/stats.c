@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "probe.h"
+
+struct Stats *stats_create(void) {
+    struct Stats *stats = malloc(sizeof(struct Stats));
+    if (stats == NULL) {
+        printf("Unable to allocate stats - exiting\n");
+        exit(1);
+    }
+    stats->num_threads = 0;
+    stats->time = 0.0;
+    stats->thread = NULL;
+    return stats;
+}
+
+void stats_begin(struct Stats *stats, int num_threads) {
+    if (num_threads > stats->num_threads) {
+        free(stats->thread);
+        stats->thread = aligned_alloc(64, num_threads * sizeof(struct ThreadStats));
+        if (stats->thread == NULL) {
+            printf("Unable to allocate stats - exiting\n");
+            exit(1);
+        }
+    }
+    memset(stats->thread, 0, num_threads * sizeof(struct ThreadStats));
+    stats->num_threads = num_threads;
+    stats->time = 0.0;
+}
+
+// counters summed over all threads, with the largest max_depth
+static struct ThreadStats total(const struct Stats *stats) {
+    struct ThreadStats sum;
+    memset(&sum, 0, sizeof(sum));
+    for (int i = 0; i < stats->num_threads; i++) {
+        const struct ThreadStats *st = &(stats->thread[i]);
+        sum.intervals += st->intervals;
+        sum.evaluations += st->evaluations;
+        sum.max_depth = (st->max_depth > sum.max_depth) ? st->max_depth : sum.max_depth;
+        sum.tasks += st->tasks;
+        sum.eval_time += st->eval_time;
+        sum.lock_time += st->lock_time;
+        sum.idle_time += st->idle_time;
+    }
+    return sum;
+}
+
+static void print_row(FILE *file, const char *name, const struct ThreadStats *st) {
+    fprintf(file, "%6s %12ld %12ld %9ld %9ld %10.6f %10.6f %10.6f\n", name, st->intervals, st->evaluations,
+            st->max_depth, st->tasks, st->eval_time, st->lock_time, st->idle_time);
+}
+
+void stats_print(const struct Stats *stats, FILE *file) {
+    char name[16];
+    fprintf(file, "%6s %12s %12s %9s %9s %10s %10s %10s\n", "Thread", "Intervals", "Evaluations",
+            "MaxDepth", "Tasks", "Eval(s)", "Lock(s)", "Idle(s)");
+    for (int i = 0; i < stats->num_threads; i++) {
+        snprintf(name, sizeof(name), "%d", i);
+        print_row(file, name, &(stats->thread[i]));
+    }
+    struct ThreadStats sum = total(stats);
+    print_row(file, "Total", &sum);
+    fprintf(file, "Time(s) = %f\n", stats->time);
+}
+
+static void json_object(FILE *file, const struct ThreadStats *st) {
+    fprintf(file, "{\"intervals\": %ld, \"evaluations\": %ld, \"max_depth\": %ld, \"tasks\": %ld, "
+            "\"eval_time\": %.9f, \"lock_time\": %.9f, \"idle_time\": %.9f}",
+            st->intervals, st->evaluations, st->max_depth, st->tasks, st->eval_time, st->lock_time, st->idle_time);
+}
+
+void stats_json(const struct Stats *stats, FILE *file) {
+    struct ThreadStats sum = total(stats);
+    fprintf(file, "{\"time\": %.9f, \"num_threads\": %d, \"total\": ", stats->time, stats->num_threads);
+    json_object(file, &sum);
+    fprintf(file, ", \"threads\": [");
+    for (int i = 0; i < stats->num_threads; i++) {
+        fputs((i > 0) ? ", " : "", file);
+        json_object(file, &(stats->thread[i]));
+    }
+    fprintf(file, "]}\n");
+}
+
+void stats_free(struct Stats *stats) {
+    free(stats->thread);
+    free(stats);
+}
@@ -0,0 +1,40 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+
+// Opt-in per-thread counters. Point Options.stats at a struct Stats from
+// stats_create() and integrate() fills it in, clearing it first. With stats
+// left NULL every probe in the strategies is one pointer test, and
+// omp_get_wtime() is only called while stats are being collected.
+
+// counters of one thread, padded so that each thread owns its cache line
+struct ThreadStats {
+    _Alignas(64) long intervals; // intervals processed
+    long evaluations;            // integrand calls
+    long max_depth;              // most entries seen in the queue, deque or heap this thread used
+    long tasks;                  // tasks spawned (STRATEGY_RECURSIVE)
+    double eval_time;            // seconds in the integrand
+    double lock_time;            // seconds waiting for locks
+    double idle_time;            // seconds looking for work without finding any, or waiting at barriers
+};
+
+struct Stats {
+    int num_threads;             // threads of the last run
+    double time;                 // wall-clock seconds of the last run
+    struct ThreadStats *thread;  // one entry per thread
+};
+
+// empty stats
+struct Stats *stats_create(void);
+
+// write the counters as a table, one row per thread and a total
+void stats_print(const struct Stats *stats, FILE *file);
+
+// write the counters as a JSON object
+void stats_json(const struct Stats *stats, FILE *file);
+
+// release stats
+void stats_free(struct Stats *stats);
+
+#endif
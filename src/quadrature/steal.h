@@ -0,0 +1,136 @@
+#ifndef STEAL_H
+#define STEAL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <omp.h>
+#include "accumulator.h"
+#include "backoff.h"
+#include "deque.h"
+#include "numa.h"
+#include "probe.h"
+#include "rule.h"
+#include "solvers.h"
+
+// Work-stealing loop shared by integrate_work_stealing() and the solvers
+// generated by specialise.h. Only the estimate differs between them, so it
+// is passed in and the loop is forced inline: a caller passing a constant
+// estimate gets its own copy with the estimate, and the integrand, inlined.
+
+// state shared by every thread of one work-stealing integration
+struct WorkStealing {
+    double (*func)(double);      // integrand
+    const struct GKRule *gk;     // Gauss-Kronrod pair, or NULL for Simpson's rule
+    struct Interval whole;       // root interval
+    struct Deque *deques;        // one deque per thread
+    struct Accumulator *acc;     // per-thread partial sums
+    _Atomic long outstanding;    // intervals that are queued or currently being processed
+    int *domain;                 // NUMA domain of each thread (numa), or NULL
+    int num_domains;             // NUMA domains on this machine (numa)
+    struct Stats *stats;         // per-thread counters, or NULL
+    struct Budget *budget;       // limits on the run, or NULL
+    struct Progress *progress;   // progressive results, or NULL
+    struct Cache *cache;         // integrand values kept between runs, or NULL
+};
+
+// Estimate of the integral over interval, with its error in *err. For
+// Simpson's rule *fd and *fe are set to the quarter-point values that the
+// subintervals reuse, otherwise to 0.
+typedef double (*Estimate)(const struct WorkStealing *state, const struct Interval *interval,
+                           double *fd, double *fe, double *err);
+
+// Each thread works from its own deque and steals when it runs dry; points
+// is the number of integrand calls per estimate
+static inline __attribute__((always_inline)) void steal_worker(struct WorkStealing *state, Estimate estimate, long points) {
+    int id = omp_get_thread_num();
+    int team = omp_get_num_threads(); // may be fewer than requested
+    struct Deque *deques = state->deques;
+    struct Deque *own = &deques[id];
+    struct Accumulator *sum = &(state->acc[id]);
+    struct ThreadStats *st = thread_stats(state->stats, id);
+    int *order = NULL; // victims in steal order (numa), or NULL to cycle through the team
+    int victim = id;
+    int delay = 1; // idle spin, see backoff()
+
+    cache_enter(state->cache);
+
+    // Each thread initialises its own deque so its storage is local to it
+    deque_init(own);
+    if (id == 0) {
+        deque_push(state->whole, own);
+    }
+    if (state->domain != NULL) {
+        state->domain[id] = numa_domain(state->num_domains);
+    }
+    #pragma omp barrier
+    if (state->domain != NULL) {
+        // Steal within our own domain before reaching across to another one
+        order = malloc((team > 1 ? team - 1 : 1) * sizeof(int));
+        if (order == NULL) {
+            printf("Unable to allocate deques - exiting\n");
+            exit(1);
+        }
+        numa_victims(id, team, state->domain, order);
+    }
+
+    while (1) {
+        struct Interval interval;
+        double t = probe_start(st);
+        int found = deque_pop(own, &interval);
+
+        // Own deque is empty, try the other threads in turn
+        for (int k = 1; !found && k < team; k++) {
+            victim = (order != NULL) ? order[k - 1] : (victim + 1) % team;
+            if (victim != id) {
+                found = deque_steal(&deques[victim], &interval);
+            }
+        }
+
+        if (!found) {
+            // No work anywhere we looked - finished only if nothing is outstanding,
+            // otherwise wait a while before looking again
+            if (atomic_load(&(state->outstanding)) == 0) {
+                probe_idle(st, t);
+                break;
+            }
+            backoff(&delay);
+            probe_idle(st, t);
+            continue;
+        }
+        delay = 1;
+
+        double h = interval.right - interval.left;
+        double fd, fe, err;
+        t = probe_start(st);
+        double quad = estimate(state, &interval, &fd, &fe, &err);
+        probe_eval(st, points, t);
+        probe_intervals(st, 1);
+        budget_charge(state->budget, points);
+
+        if ((err < interval.tol) || (h < 1.0e-12) || budget_stop(state->budget, h, err)) {
+            // Tolerance is met or the budget is spent, add to this thread's total
+            accumulate(sum, interval.left, quad);
+            progress_leaf(state->progress, id, h, quad, interval.share);
+            atomic_fetch_sub(&(state->outstanding), 1);
+        } else {
+            // Tolerance is not met, split interval in two and push both halves on our own deque
+            struct Interval i1, i2;
+            split_interval(&interval, fd, fe, err, &i1, &i2);
+            progress_split(state->progress, id, interval.share, err);
+
+            // one interval consumed, two added
+            atomic_fetch_add(&(state->outstanding), 1);
+            deque_push(i2, own);
+            deque_push(i1, own);
+            probe_depth(st, deque_size(own));
+        }
+    }
+
+    // Thieves may still be reading from our deque until everyone is done
+    #pragma omp barrier
+    deque_destroy(own);
+    free(order);
+}
+
+#endif
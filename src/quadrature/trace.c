@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "probe.h"
+
+struct Trace *trace_create(long events_per_thread) {
+    struct Trace *trace = malloc(sizeof(struct Trace));
+    if (trace == NULL) {
+        printf("Unable to allocate trace - exiting\n");
+        exit(1);
+    }
+    trace->num_threads = 0;
+    trace->capacity = (events_per_thread > 0) ? events_per_thread : 1;
+    trace->origin = 0.0;
+    trace->thread = NULL;
+    return trace;
+}
+
+void trace_begin(struct Trace *trace, int num_threads) {
+    if (num_threads > trace->num_threads) {
+        for (int i = 0; i < trace->num_threads; i++) {
+            free(trace->thread[i].event);
+        }
+        free(trace->thread);
+        trace->thread = aligned_alloc(64, num_threads * sizeof(struct TraceBuffer));
+        if (trace->thread == NULL) {
+            printf("Unable to allocate trace - exiting\n");
+            exit(1);
+        }
+        for (int i = 0; i < num_threads; i++) {
+            trace->thread[i].event = malloc(trace->capacity * sizeof(struct Event));
+            if (trace->thread[i].event == NULL) {
+                printf("Unable to allocate trace - exiting\n");
+                exit(1);
+            }
+        }
+        trace->num_threads = num_threads;
+    }
+    for (int i = 0; i < trace->num_threads; i++) {
+        trace->thread[i].count = 0;
+    }
+    trace->origin = omp_get_wtime();
+}
+
+// Complete ("X") events for spans and thread-scoped instant ("i") events,
+// with times in microseconds
+void trace_write(const struct Trace *trace, const char *path) {
+    FILE *file = fopen(path, "w");
+    int first = 1;
+
+    if (file == NULL) {
+        printf("Unable to open %s - exiting\n", path);
+        exit(1);
+    }
+    fprintf(file, "{\"traceEvents\": [\n");
+    for (int i = 0; i < trace->num_threads; i++) {
+        const struct TraceBuffer *tb = &(trace->thread[i]);
+        long begin = (tb->count > trace->capacity) ? tb->count - trace->capacity : 0;
+        for (long j = begin; j < tb->count; j++) {
+            const struct Event *e = &(tb->event[j % trace->capacity]);
+            fprintf(file, "%s{\"name\": \"%s\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, ", first ? "" : ",\n",
+                    e->name, i, 1e6 * e->start);
+            if (e->dur >= 0.0) {
+                fprintf(file, "\"ph\": \"X\", \"dur\": %.3f}", 1e6 * e->dur);
+            } else {
+                fprintf(file, "\"ph\": \"i\", \"s\": \"t\"}");
+            }
+            first = 0;
+        }
+    }
+    fprintf(file, "\n], \"displayTimeUnit\": \"ms\"}\n");
+    if (fclose(file) != 0) {
+        printf("Unable to write %s - exiting\n", path);
+        exit(1);
+    }
+}
+
+void trace_free(struct Trace *trace) {
+    for (int i = 0; i < trace->num_threads; i++) {
+        free(trace->thread[i].event);
+    }
+    free(trace->thread);
+    free(trace);
+}
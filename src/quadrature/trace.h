@@ -0,0 +1,24 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Opt-in timeline tracing. Point Options.trace at a struct Trace from
+// trace_create() and integrate() records events into a ring buffer per
+// thread, cleared at the start of each call: task spawn, run and taskwait
+// in STRATEGY_RECURSIVE, enqueue, dequeue and lock waits in STRATEGY_LIFO,
+// and converged intervals in both. Each thread only writes its own buffer,
+// so recording takes no lock; when a buffer is full the oldest events are
+// overwritten. trace_write() saves the events in the Chrome trace-event
+// format, which chrome://tracing and Perfetto can display.
+
+struct Trace;
+
+// empty trace keeping the last events_per_thread events of each thread
+struct Trace *trace_create(long events_per_thread);
+
+// write the recorded events to path as Chrome trace-event JSON
+void trace_write(const struct Trace *trace, const char *path);
+
+// release a trace
+void trace_free(struct Trace *trace);
+
+#endif
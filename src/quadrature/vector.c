@@ -0,0 +1,292 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <omp.h>
+#include "backoff.h"
+#include "probe.h"
+#include "records.h"
+#include "vector.h"
+
+// Each pending interval is stored as one record of 2 + 3n doubles: left,
+// right, then the n values at the left end, the midpoint and the right end.
+// Each thread sums its converged intervals into one contiguous row of n
+// running sums followed by n compensation terms, so a leaf is added with
+// one simd loop over the components. The summation follows the same
+// SUM_NEUMAIER and SUM_SORTED choices as accumulator.h.
+
+#define LEAFCHUNK 1024 // initial number of recorded leaves per thread
+
+// per-thread totals of converged intervals, aligned so that each thread owns its cache line
+struct VectorSum {
+    _Alignas(64) double *sum; // n running sums, then n compensation terms (SUM_NEUMAIER)
+    double *leaf;             // converged intervals, each left then its n integrals (SUM_SORTED)
+    long count;               // number of recorded leaves
+    long capacity;            // allocated number of leaves
+};
+
+// add value to the compensated (Neumaier) running sums sum and comp, component by component
+static void add_row(double *restrict sum, double *restrict comp, const double *restrict value, int n) {
+    #pragma omp simd
+    for (int k = 0; k < n; k++) {
+        double t = sum[k] + value[k];
+        comp[k] += (fabs(sum[k]) >= fabs(value[k])) ? (sum[k] - t) + value[k] : (value[k] - t) + sum[k];
+        sum[k] = t;
+    }
+}
+
+// add the integrals quad over a converged interval to a thread's totals
+static void add_leaf(struct VectorSum *total, double left, const double *restrict quad, int n) {
+#if defined(SUM_SORTED)
+    if (total->count == total->capacity) {
+        total->capacity = (total->capacity == 0) ? LEAFCHUNK : 2 * total->capacity;
+        total->leaf = realloc(total->leaf, total->capacity * (n + 1) * sizeof(double));
+        if (total->leaf == NULL) {
+            printf("Unable to allocate leaf storage - exiting\n");
+            exit(1);
+        }
+    }
+    double *leaf = total->leaf + total->count * (n + 1);
+    leaf[0] = left;
+    #pragma omp simd
+    for (int k = 0; k < n; k++) {
+        leaf[1 + k] = quad[k];
+    }
+    total->count++;
+#elif defined(SUM_NEUMAIER)
+    (void) left;
+    add_row(total->sum, total->sum + n, quad, n);
+#else
+    (void) left;
+    double *restrict sum = total->sum;
+    #pragma omp simd
+    for (int k = 0; k < n; k++) {
+        sum[k] += quad[k];
+    }
+#endif
+}
+
+#if defined(SUM_SORTED)
+// order recorded leaves by position; the intervals of one subdivision never share a left end
+static int compare_leaf(const void *a, const void *b) {
+    double la = *(const double *) a, lb = *(const double *) b;
+    return (la > lb) - (la < lb);
+}
+#endif
+
+// combine the threads' totals in a fixed order into result and release them
+static void reduce_sums(struct VectorSum *totals, int num_threads, int n, double *result) {
+    double *sum = calloc(2 * n, sizeof(double)), *comp = sum + n;
+    if (sum == NULL) {
+        printf("Unable to allocate partial sums - exiting\n");
+        exit(1);
+    }
+#if defined(SUM_SORTED)
+    long count = 0;
+    for (int i = 0; i < num_threads; i++) {
+        count += totals[i].count;
+    }
+    double *leaf = malloc((count > 0 ? count : 1) * (n + 1) * sizeof(double));
+    if (leaf == NULL) {
+        printf("Unable to allocate leaf storage - exiting\n");
+        exit(1);
+    }
+    count = 0;
+    for (int i = 0; i < num_threads; i++) {
+        if (totals[i].count > 0) {
+            memcpy(leaf + count * (n + 1), totals[i].leaf, totals[i].count * (n + 1) * sizeof(double));
+        }
+        count += totals[i].count;
+        free(totals[i].leaf);
+    }
+    qsort(leaf, count, (n + 1) * sizeof(double), compare_leaf);
+    for (long j = 0; j < count; j++) {
+        add_row(sum, comp, leaf + j * (n + 1) + 1, n);
+    }
+    free(leaf);
+#else
+    for (int i = 0; i < num_threads; i++) {
+        if (totals[i].sum != NULL) {
+            add_row(sum, comp, totals[i].sum, n);
+            add_row(sum, comp, totals[i].sum + n, n);
+        }
+    }
+#endif
+    for (int i = 0; i < num_threads; i++) {
+        free(totals[i].sum);
+    }
+    for (int k = 0; k < n; k++) {
+        result[k] = sum[k] + comp[k];
+    }
+    free(sum);
+    free(totals);
+}
+
+void integrate_vector(void (*func)(double x, double *f, int n), int n, double a, double b, double tol,
+                      double *result, const struct Options *opts) {
+    struct Options defaults;
+
+    if (opts == NULL) {
+        default_options(&defaults);
+        opts = &defaults;
+    }
+    if (opts->strategy != STRATEGY_SERIAL && opts->strategy != STRATEGY_LIFO
+        && opts->strategy != STRATEGY_WORK_STEALING) {
+        printf("Strategy %s is not supported for vector integrands - exiting\n", strategy_name(opts->strategy));
+        exit(1);
+    }
+    int num_threads = (opts->num_threads > 0) ? opts->num_threads : omp_get_max_threads();
+    if (opts->strategy == STRATEGY_SERIAL) {
+        num_threads = 1;
+    }
+    int shared = (opts->strategy != STRATEGY_WORK_STEALING);
+    int num_stacks = shared ? 1 : num_threads;
+    int stride = 2 + 3 * n;
+    struct RecordStack *stacks = malloc(num_stacks * sizeof(struct RecordStack));
+    struct VectorSum *totals = aligned_alloc(64, num_threads * sizeof(struct VectorSum));
+    _Atomic long outstanding = 1; // intervals that are queued or currently being processed
+
+    if (stacks == NULL || totals == NULL) {
+        printf("Unable to allocate queue storage - exiting\n");
+        exit(1);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        totals[i].sum = NULL;
+        totals[i].leaf = NULL;
+        totals[i].count = 0;
+        totals[i].capacity = 0;
+    }
+
+    double start = 0.0;
+    if (opts->stats != NULL) {
+        stats_begin(opts->stats, num_threads);
+        start = omp_get_wtime();
+        opts->stats->thread[0].evaluations = 3;
+    }
+
+    // Set up the initial interval
+    for (int s = 0; s < num_stacks; s++) {
+        records_init(&stacks[s], stride * sizeof(double));
+    }
+    double *whole = records_reserve(&stacks[0], 1);
+    whole[0] = a;
+    whole[1] = b;
+    func(a, &whole[2], n);
+    func((a + b) / 2.0, &whole[2 + n], n);
+    func(b, &whole[2 + 2 * n], n);
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int id = omp_get_thread_num();
+        int team = omp_get_num_threads(); // may be fewer than requested
+        struct RecordStack *own = &stacks[shared ? 0 : id];
+        struct ThreadStats *st = thread_stats(opts->stats, id);
+        double *interval = malloc(stride * sizeof(double));
+        double *fd = malloc(2 * n * sizeof(double)), *fe = fd + n;
+        double *quad = malloc(n * sizeof(double));
+        struct VectorSum *total = &totals[id];
+        int victim = id;
+        int delay = 1; // idle spin, see backoff()
+
+        // Whole cache lines, so no two threads' sums share one
+        total->sum = aligned_alloc(64, (2 * n * sizeof(double) + 63) / 64 * 64);
+        if (interval == NULL || fd == NULL || quad == NULL || total->sum == NULL) {
+            printf("Unable to allocate interval storage - exiting\n");
+            exit(1);
+        }
+        #pragma omp simd
+        for (int k = 0; k < 2 * n; k++) {
+            total->sum[k] = 0.0;
+        }
+
+        while (1) {
+            double t = probe_start(st);
+            int found = records_pop(own, interval, 1, st);
+
+            // Own stack is empty, take the widest interval from the other threads in turn
+            for (int k = 1; !found && !shared && k < team; k++) {
+                victim = (victim + 1) % team;
+                if (victim != id) {
+                    found = records_pop(&stacks[victim], interval, 0, st);
+                }
+            }
+
+            if (!found) {
+                // No work anywhere we looked - finished only if nothing is outstanding,
+                // otherwise wait a while before looking again
+                if (atomic_load(&outstanding) == 0) {
+                    probe_idle(st, t);
+                    break;
+                }
+                backoff(&delay);
+                probe_idle(st, t);
+                continue;
+            }
+            delay = 1;
+
+            double left = interval[0], right = interval[1];
+            const double *f_left = &interval[2], *f_mid = &interval[2 + n], *f_right = &interval[2 + 2 * n];
+            double h = right - left;
+            double c = (left + right) / 2.0;
+            t = probe_start(st);
+            func((left + c) / 2.0, fd, n);
+            func((c + right) / 2.0, fe, n);
+            probe_eval(st, 2, t);
+            probe_intervals(st, 1);
+
+            // Calculate integral estimates using 3 and 5 points respectively, for every component
+            double err = 0.0;
+            #pragma omp simd reduction(max:err)
+            for (int k = 0; k < n; k++) {
+                double q1 = h / 6.0 * (f_left[k] + 4.0 * f_mid[k] + f_right[k]);
+                double q2 = h / 12.0 * (f_left[k] + 4.0 * fd[k] + 2.0 * f_mid[k] + 4.0 * fe[k] + f_right[k]);
+                quad[k] = q2 + (q2 - q1) / 15.0;
+                err = fmax(err, fabs(q2 - q1));
+            }
+
+            if ((err < tol) || (h < 1.0e-12)) {
+                // Tolerance is met for every component, add to this thread's totals
+                add_leaf(total, left, quad, n);
+                atomic_fetch_sub(&outstanding, 1);
+            } else {
+                // Tolerance is not met, split interval in two and push both halves,
+                // the left one last so that it is processed first
+                // one interval consumed, two added
+                atomic_fetch_add(&outstanding, 1);
+                t = probe_start(st);
+                omp_set_lock(&(own->lock));
+                probe_lock(st, t);
+                double *i2 = records_reserve(own, 2), *i1 = i2 + stride;
+                i2[0] = c;
+                i2[1] = right;
+                i1[0] = left;
+                i1[1] = c;
+                #pragma omp simd
+                for (int k = 0; k < n; k++) {
+                    i1[2 + k] = f_left[k];
+                    i1[2 + n + k] = fd[k];
+                    i1[2 + 2 * n + k] = f_mid[k];
+                    i2[2 + k] = f_mid[k];
+                    i2[2 + n + k] = fe[k];
+                    i2[2 + 2 * n + k] = f_right[k];
+                }
+                probe_depth(st, own->last - own->first);
+                omp_unset_lock(&(own->lock));
+            }
+        }
+
+        free(interval);
+        free(fd);
+        free(quad);
+    }
+
+    reduce_sums(totals, num_threads, n, result);
+    for (int s = 0; s < num_stacks; s++) {
+        records_destroy(&stacks[s]);
+    }
+    free(stacks);
+    if (opts->stats != NULL) {
+        opts->stats->time = omp_get_wtime() - start;
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef VECTOR_H
+#define VECTOR_H
+
+#include "quadrature.h"
+
+// Integrals of n related functions over one shared subdivision. func(x, f, n)
+// sets f[k], k < n, to the value of component k at x. Every interval carries
+// n-wide end and mid values, and it is converged when the largest difference
+// between the 3- and 5-point Simpson estimates over the components is below
+// tol, so one tree and one scheduling pass serve all n integrals.
+
+// integrate every component of func over [a, b], storing the integrals in result
+// Intervals are scheduled by opts->strategy: STRATEGY_SERIAL, STRATEGY_LIFO
+// (one shared stack) or STRATEGY_WORK_STEALING (one stack per thread, stealing
+// the widest intervals); the others are not supported. opts may be NULL.
+void integrate_vector(void (*func)(double x, double *f, int n), int n, double a, double b, double tol,
+                      double *result, const struct Options *opts);
+
+#endif
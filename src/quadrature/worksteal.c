@@ -0,0 +1,69 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "numa.h"
+#include "rule.h"
+#include "solvers.h"
+#include "steal.h"
+
+// estimate through the run's integrand pointer and rule
+static double estimate(const struct WorkStealing *state, const struct Interval *interval,
+                       double *fd, double *fe, double *err) {
+    const struct GKRule *gk = state->gk;
+    *fd = 0.0;
+    *fe = 0.0;
+    if (gk != NULL) {
+        // Kronrod estimate, none of whose nodes are reused by the subintervals
+        return gk_apply(gk, state->func, interval->left, interval->right, err);
+    }
+    double h = interval->right - interval->left;
+    double c = (interval->left + interval->right) / 2.0;
+
+    // Calculate integral estimates using 3 and 5 points respectively
+    *fd = state->func((interval->left + c) / 2.0);
+    *fe = state->func((c + interval->right) / 2.0);
+    double q1 = h / 6.0 * (interval->f_left + 4.0 * interval->f_mid + interval->f_right);
+    double q2 = h / 12.0 * (interval->f_left + 4.0 * *fd + 2.0 * interval->f_mid + 4.0 * *fe + interval->f_right);
+    *err = fabs(q2 - q1);
+    return q2 + (q2 - q1) / 15.0;
+}
+
+// the loop of steal.h with the integrand called through a pointer
+static void worker(struct WorkStealing *state) {
+    steal_worker(state, estimate, (state->gk == NULL) ? 2 : 2 * state->gk->n + 1);
+}
+
+double integrate_work_stealing(double (*func)(double), struct Interval whole, const struct Options *opts, int num_threads) {
+    struct WorkStealing state;
+
+    state.func = func;
+    state.gk = gk_rule(opts->rule);
+    state.whole = whole;
+    state.deques = malloc(num_threads * sizeof(struct Deque));
+    state.acc = new_accumulators(num_threads);
+    atomic_init(&(state.outstanding), 1);
+    state.domain = opts->numa ? malloc(num_threads * sizeof(int)) : NULL;
+    state.num_domains = opts->numa ? numa_domains() : 1;
+    state.stats = opts->stats;
+    state.budget = opts->budget;
+    state.progress = opts->progress;
+    state.cache = opts->cache;
+    if (state.deques == NULL || (opts->numa && state.domain == NULL)) {
+        printf("Unable to allocate deques - exiting\n");
+        exit(1);
+    }
+
+    // proc_bind cannot be chosen at run time, hence the two regions
+    if (opts->numa) {
+        #pragma omp parallel num_threads(num_threads) proc_bind(close)
+        worker(&state);
+    } else {
+        #pragma omp parallel num_threads(num_threads)
+        worker(&state);
+    }
+
+    free(state.domain);
+    free(state.deques);
+    return reduce(state.acc, num_threads);
+}
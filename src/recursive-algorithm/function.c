@@ -1,6 +1,8 @@
 #include <math.h> 
 #include <stdio.h>
 
+// euler(), euler_closed() and func1() are also compiled for offload devices
+#pragma omp declare target
 double euler(double init, double step, double alpha, int numsteps)
 {
    double y = init; 
@@ -12,10 +14,104 @@ double euler(double init, double step, double alpha, int numsteps)
    return y; 
 }
 
+// Closed form of euler(). The recurrence y += step * (alpha - y) is linear
+// with constant coefficients, so after numsteps steps
+//    y = alpha + (init - alpha) * (1 - step)^numsteps
+// where decay is the precomputed factor (1 - step)^numsteps.
+// The result differs from euler() in the last few bits because it does
+// not reproduce the rounding of each individual step.
+double euler_closed(double init, double alpha, double decay)
+{
+   return alpha + (init - alpha) * decay;
+}
+
 
 double func1(double x) 
 {
    double alpha = 100000.0 *sin(x*100000.0); 
+#ifdef EULER_CLOSED_FORM
+   // constant arguments, so the compiler folds this to a single constant
+   const double decay = pow(1.0 - 0.0001, 1000);
+   return euler_closed(0.0, alpha, decay);
+#else
    return euler(0.0, 0.0001, alpha, 1000); 
+#endif
 } 
+#pragma omp end declare target
+
+// evaluate func1 at n points in one call
+void func1_batch(const double *x, double *y, int n)
+{
+   for (int i = 0; i < n; i++) {
+      y[i] = func1(x[i]);
+   }
+}
+
+#define VECLEN 8 // number of abscissae evaluated together by func1_vec
+
+// sin() written so that the compiler can vectorise calls inside a simd loop.
+// Arguments are reduced by multiples of pi/2 using a three-part Cody-Waite
+// split of pi/2, which is accurate for |x| up to about 1e9, then evaluated
+// with the fdlibm minimax polynomials for sin and cos on [-pi/4, pi/4].
+#pragma omp declare simd
+static inline double vsin(double x)
+{
+   const double invpio2 = 6.36619772367581382433e-01;
+   const double pio2_1 = 1.57079632673412561417e+00;
+   const double pio2_2 = 6.07710050630396597660e-11;
+   const double pio2_2t = 2.02226624879595063154e-21;
+   const double shift = 6755399441055744.0; // 1.5 * 2^52, rounds to nearest integer
+
+   double k = (x * invpio2 + shift) - shift;
+   int q = (int) k;
+   double r = ((x - k * pio2_1) - k * pio2_2) - k * pio2_2t;
+   double z = r * r;
 
+   double s = r + r * z * (-1.66666666666666324348e-01 + z * (8.33333333332248946124e-03
+            + z * (-1.98412698298579493134e-04 + z * (2.75573137070700676789e-06
+            + z * (-2.50507602534068634195e-08 + z * 1.58969099521155010221e-10)))));
+   double c = 1.0 - 0.5 * z + z * z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03
+            + z * (2.48015872894767294178e-05 + z * (-2.75573143513906633035e-07
+            + z * (2.08757232129817482790e-09 + z * -1.13596475577881948265e-11)))));
+
+   double v = (q & 1) ? c : s;
+   return (q & 2) ? -v : v;
+}
+
+// euler() applied to n independent values of alpha at once
+void euler_vec(double init, double step, const double *alpha, double *y, int n, int numsteps)
+{
+   #pragma omp simd
+   for (int j = 0; j < n; j++) {
+      y[j] = init;
+   }
+   for (int i = 0; i<numsteps; i++) {
+      // the recurrence is serial in i but independent across lanes
+      #pragma omp simd
+      for (int j = 0; j < n; j++) {
+         y[j] += step * (alpha[j] - y[j]);
+      }
+   }
+}
+
+// vectorised func1 at n points, VECLEN lanes at a time
+void func1_vec(const double *x, double *y, int n)
+{
+   for (int i = 0; i < n; i += VECLEN) {
+      int m = (n - i < VECLEN) ? n - i : VECLEN;
+      double alpha[VECLEN];
+      #pragma omp simd
+      for (int j = 0; j < m; j++) {
+         alpha[j] = 100000.0 * vsin(x[i + j] * 100000.0);
+      }
+#ifdef EULER_CLOSED_FORM
+      const double decay = pow(1.0 - 0.0001, 1000);
+      #pragma omp simd
+      for (int j = 0; j < m; j++) {
+         y[i + j] = euler_closed(0.0, alpha[j], decay);
+      }
+#else
+      euler_vec(0.0, 0.0001, alpha, &y[i], m, 1000);
+#endif
+   }
+}
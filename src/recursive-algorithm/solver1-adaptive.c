@@ -0,0 +1,127 @@
+#include <math.h>
+#include <omp.h>
+#include <stdio.h>
+#include "function.h"
+
+#define TASKS_PER_THREAD 4 // pending tasks per thread before new splits run inline
+
+struct Interval {
+    double left;    // left boundary
+    double right;   // right boundary
+    double tol;     // tolerance
+    double f_left;  // function value at left boundary
+    double f_mid;   // function value at midpoint
+    double f_right; // function value at right boundary
+};
+
+int pending = 0;     // tasks created but not yet started
+int max_pending = 0; // cutoff above which no new tasks are created
+
+double simpson(double (*func)(double), struct Interval interval) {
+    // Already have function evaluations at each end of the interval and in the middle
+    // Now get function values at one-quarter and three-quarter points
+    double h = interval.right - interval.left;
+    double c = (interval.left + interval.right) / 2.0;
+    double d = (interval.left + c) / 2.0;
+    double e = (c + interval.right) / 2.0;
+    double fd = func(d);
+    double fe = func(e);
+
+    // Compute integral estimates using 3 and 5 points respectively
+    double q1 = h / 6.0 * (interval.f_left + 4.0 * interval.f_mid + interval.f_right);
+    double q2 = h / 12.0 * (interval.f_left + 4.0 * fd + 2.0 * interval.f_mid + 4.0 * fe + interval.f_right);
+
+    if ((fabs(q2 - q1) < interval.tol) || ((interval.right - interval.left) < 1.0e-12)) {
+        // Tolerance is met or interval is small enough, return
+        // Add an error correction term to the more accurate estimate (q2)
+        return q2 + (q2 - q1) / 15.0;
+    } else {
+        // Tolerance is not met, split interval in two and make recursive calls
+        struct Interval i1, i2;
+        double quad1, quad2;
+        int queued;
+
+        // Set up the left subinterval
+        i1.left = interval.left;
+        i1.right = c;
+        i1.tol = interval.tol;
+        i1.f_left = interval.f_left;
+        i1.f_mid = fd;
+        i1.f_right = interval.f_mid;
+
+        // Set up the right subinterval
+        i2.left = c;
+        i2.right = interval.right;
+        i2.tol = interval.tol;
+        i2.f_left = interval.f_mid;
+        i2.f_mid = fe;
+        i2.f_right = interval.f_right;
+
+        #pragma omp atomic read
+        queued = pending;
+
+        if (queued < max_pending) {
+            // Idle threads may be waiting for work, so create OpenMP tasks
+            #pragma omp atomic
+            pending += 2;
+
+            #pragma omp task shared(quad1)
+            {
+                #pragma omp atomic
+                pending--;
+                // Recursively compute the integral for the left subinterval
+                quad1 = simpson(func, i1);
+            }
+
+            #pragma omp task shared(quad2)
+            {
+                #pragma omp atomic
+                pending--;
+                // Recursively compute the integral for the right subinterval
+                quad2 = simpson(func, i2);
+            }
+
+            // Wait for the tasks to complete before proceeding
+            #pragma omp taskwait
+        } else {
+            // Enough tasks are already waiting to keep every thread busy,
+            // so compute the integrals sequentially
+            quad1 = simpson(func, i1);
+            quad2 = simpson(func, i2);
+        }
+
+        // Return the sum of the integrals over the subintervals
+        return quad1 + quad2;
+    }
+}
+
+int main(void) {
+    struct Interval whole;
+    double quad;
+
+    double start = omp_get_wtime(); // Start the timer
+
+    // Create initial interval
+    whole.left = 0.0;
+    whole.right = 10.0;
+    whole.tol = 1e-06;
+    whole.f_left = func1(whole.left);
+    whole.f_right = func1(whole.right);
+    whole.f_mid = func1((whole.left + whole.right) / 2.0);
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            // The cutoff scales with the team, so no recompiling per machine
+            max_pending = TASKS_PER_THREAD * omp_get_num_threads();
+            // Call recursive quadrature routine
+            quad = simpson(func1, whole);
+        }
+    }
+
+    double time = omp_get_wtime() - start; // Calculate the elapsed time
+    printf("Max Pending Tasks = %d\n", max_pending);
+    printf("Result = %e\n", quad);
+    printf("Time(s) = %f\n", time);
+}
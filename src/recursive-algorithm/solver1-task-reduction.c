@@ -0,0 +1,125 @@
+#include <math.h>
+#include <omp.h>
+#include <stdio.h>
+#include "function.h"
+
+#define TASKS_PER_THREAD 4 // pending tasks per thread before new splits run inline
+
+struct Interval {
+    double left;    // left boundary
+    double right;   // right boundary
+    double tol;     // tolerance
+    double f_left;  // function value at left boundary
+    double f_mid;   // function value at midpoint
+    double f_right; // function value at right boundary
+};
+
+double quad = 0.0;   // task reduction target for spawned subtrees
+int pending = 0;     // tasks created but not yet started
+int max_pending = 0; // cutoff above which no new tasks are created
+
+// Integrate an interval without ever waiting on child tasks.
+// The left child of each split is either spawned as a task, which adds its
+// result straight into the enclosing task reduction, or computed inline;
+// the right child is handled by the next iteration of the loop in this frame.
+// Returns the sum of the subtrees that were not spawned as tasks.
+double simpson(double (*func)(double), struct Interval interval) {
+    double sum = 0.0;
+
+    while (1) {
+        // Already have function evaluations at each end of the interval and in the middle
+        // Now get function values at one-quarter and three-quarter points
+        double h = interval.right - interval.left;
+        double c = (interval.left + interval.right) / 2.0;
+        double d = (interval.left + c) / 2.0;
+        double e = (c + interval.right) / 2.0;
+        double fd = func(d);
+        double fe = func(e);
+
+        // Compute integral estimates using 3 and 5 points respectively
+        double q1 = h / 6.0 * (interval.f_left + 4.0 * interval.f_mid + interval.f_right);
+        double q2 = h / 12.0 * (interval.f_left + 4.0 * fd + 2.0 * interval.f_mid + 4.0 * fe + interval.f_right);
+
+        if ((fabs(q2 - q1) < interval.tol) || ((interval.right - interval.left) < 1.0e-12)) {
+            // Tolerance is met or interval is small enough, return
+            // Add an error correction term to the more accurate estimate (q2)
+            return sum + q2 + (q2 - q1) / 15.0;
+        }
+
+        // Tolerance is not met, split interval in two
+        struct Interval i1, i2;
+        int queued;
+
+        // Set up the left subinterval
+        i1.left = interval.left;
+        i1.right = c;
+        i1.tol = interval.tol;
+        i1.f_left = interval.f_left;
+        i1.f_mid = fd;
+        i1.f_right = interval.f_mid;
+
+        // Set up the right subinterval
+        i2.left = c;
+        i2.right = interval.right;
+        i2.tol = interval.tol;
+        i2.f_left = interval.f_mid;
+        i2.f_mid = fe;
+        i2.f_right = interval.f_right;
+
+        #pragma omp atomic read
+        queued = pending;
+
+        if (queued < max_pending) {
+            // Idle threads may be waiting for work, so hand the left subinterval to a task
+            #pragma omp atomic
+            pending++;
+
+            #pragma omp task in_reduction(+:quad)
+            {
+                #pragma omp atomic
+                pending--;
+                quad += simpson(func, i1);
+            }
+        } else {
+            // Enough tasks are already waiting, compute the left subinterval here
+            sum += simpson(func, i1);
+        }
+
+        // Carry on with the right subinterval in this frame
+        interval = i2;
+    }
+}
+
+int main(void) {
+    struct Interval whole;
+
+    double start = omp_get_wtime(); // Start the timer
+
+    // Create initial interval
+    whole.left = 0.0;
+    whole.right = 10.0;
+    whole.tol = 1e-06;
+    whole.f_left = func1(whole.left);
+    whole.f_right = func1(whole.right);
+    whole.f_mid = func1((whole.left + whole.right) / 2.0);
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            max_pending = TASKS_PER_THREAD * omp_get_num_threads();
+            double rest;
+            // All spawned tasks are complete and reduced into quad at the end of the taskgroup
+            #pragma omp taskgroup task_reduction(+:quad)
+            {
+                rest = simpson(func1, whole);
+            }
+            quad += rest;
+        }
+    }
+
+    double time = omp_get_wtime() - start; // Calculate the elapsed time
+    printf("Max Pending Tasks = %d\n", max_pending);
+    printf("Result = %e\n", quad);
+    printf("Time(s) = %f\n", time);
+}